@@ -0,0 +1,137 @@
+#include "AssetPacker.h"
+
+#include <GameEngine\AssetArchive.h>
+#include <GameEngine\MappedFile.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+using GameEngine::AssetArchive;
+using GameEngine::AssetArchiveHeader;
+using GameEngine::AssetArchiveSlot;
+
+namespace {
+
+	uint64_t alignUp(uint64_t value, uint64_t alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	void writeZeros(std::ofstream& file, uint64_t count) {
+		static const char zeros[AssetArchive::DATA_ALIGNMENT] = {};
+		file.write(zeros, count);
+	}
+
+}
+
+void AssetPacker::addFile(const std::string& name, const std::string& filePath) {
+	PackedFile file = {};
+	file.name = name;
+	file.filePath = filePath;
+	file.hash = AssetArchive::hashPath(name);
+	_files.push_back(file);
+}
+
+bool AssetPacker::write(const std::string& outputPath) {
+	if (_files.empty()) {
+		printf("There's nothing to pack!\n");
+		return false;
+	}
+
+	//Sorted by name so the same files always give the same archive, and files in the same folder end up next to each other.
+	std::sort(_files.begin(), _files.end(), [](const PackedFile& a, const PackedFile& b) { return a.name < b.name; });
+
+	//The game matches paths ignoring case and slashes, so two names that only differ by those would clash.
+	//Those have the same hash, so only files with the same hash need comparing.
+	std::vector<const PackedFile*> byHash;
+	for (auto& file : _files) {
+		byHash.push_back(&file);
+	}
+	std::sort(byHash.begin(), byHash.end(), [](const PackedFile* a, const PackedFile* b) { return a->hash < b->hash; });
+	for (size_t i = 0; i < byHash.size(); i++) {
+		for (size_t j = i + 1; j < byHash.size() && byHash[j]->hash == byHash[i]->hash; j++) {
+			if (AssetArchive::pathsMatch(byHash[i]->name, byHash[j]->name)) {
+				printf("%s and %s have the same name in an archive!\n", byHash[i]->filePath.c_str(), byHash[j]->filePath.c_str());
+				return false;
+			}
+		}
+	}
+
+	//At most half full, so a lookup only has to step past a slot or two.
+	uint32_t numSlots = 1;
+	while (numSlots < _files.size() * 2) {
+		numSlots *= 2;
+	}
+
+	AssetArchiveHeader header = {};
+	memcpy(header.magic, "GPAK", 4);
+	header.version = AssetArchive::VERSION;
+	header.numFiles = _files.size();
+	header.numSlots = numSlots;
+	header.slotsOffset = sizeof(AssetArchiveHeader);
+	header.namesOffset = header.slotsOffset + numSlots * sizeof(AssetArchiveSlot);
+
+	//Work out where everything goes before writing anything.
+	uint64_t namesSize = 0;
+	for (auto& file : _files) {
+		file.nameOffset = (uint32_t)namesSize;
+		namesSize += file.name.size();
+	}
+	uint64_t offset = alignUp(header.namesOffset + namesSize, AssetArchive::DATA_ALIGNMENT);
+	for (auto& file : _files) {
+		std::error_code error;
+		file.dataSize = std::filesystem::file_size(file.filePath, error);
+		if (error) {
+			printf("Can't read %s\n", file.filePath.c_str());
+			return false;
+		}
+		file.dataOffset = offset;
+		offset = alignUp(offset + file.dataSize, AssetArchive::DATA_ALIGNMENT);
+	}
+
+	std::vector<AssetArchiveSlot> slots(numSlots);
+	for (auto& file : _files) {
+		//Same walk that AssetArchive::find does, the first empty slot after where the hash lands.
+		uint32_t i = (uint32_t)file.hash & (numSlots - 1);
+		while (slots[i].hash != 0) {
+			i = (i + 1) & (numSlots - 1);
+		}
+		slots[i].hash = file.hash;
+		slots[i].dataOffset = file.dataOffset;
+		slots[i].dataSize = file.dataSize;
+		slots[i].nameOffset = file.nameOffset;
+		slots[i].nameLength = (uint32_t)file.name.size();
+	}
+
+	std::ofstream out(outputPath, std::ios::binary);
+	if (out.fail()) {
+		perror(outputPath.c_str());
+		return false;
+	}
+
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)&slots[0], slots.size() * sizeof(AssetArchiveSlot));
+	for (auto& file : _files) {
+		out.write(file.name.data(), file.name.size());
+	}
+
+	uint64_t written = header.namesOffset + namesSize;
+	GameEngine::MappedFile in;
+	for (auto& file : _files) {
+		writeZeros(out, file.dataOffset - written);
+		if (in.open(file.filePath) == false || in.size() != file.dataSize) {
+			printf("Can't read %s\n", file.filePath.c_str());
+			return false;
+		}
+		out.write((const char*)in.data(), in.size());
+		written = file.dataOffset + file.dataSize;
+	}
+
+	if (out.fail()) {
+		printf("Failed to write %s\n", outputPath.c_str());
+		return false;
+	}
+	return true;
+}
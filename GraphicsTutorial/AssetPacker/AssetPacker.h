@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*Builds an asset archive (see GameEngine/AssetArchive.h for the layout) out of loose files.
+Each file is stored under the name it's given, which is the path the game will ask for it by,
+like "Textures/jimmyJump_pack/PNG/Coin.png".*/
+
+class AssetPacker
+{
+public:
+	//filePath is where to read it from right now, name is what the game will call it.
+	void addFile(const std::string& name, const std::string& filePath);
+
+	//Returns false if two files have the same name, a file can't be read, or the archive can't be written.
+	bool write(const std::string& outputPath);
+
+	int getNumFiles() const { return _files.size(); }
+
+private:
+	struct PackedFile {
+		std::string name;
+		std::string filePath;
+		uint64_t hash;
+		uint64_t dataOffset;
+		uint64_t dataSize;
+		uint32_t nameOffset;
+	};
+
+	std::vector<PackedFile> _files;
+};
@@ -0,0 +1,51 @@
+#include "AssetPacker.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+void printUsage() {
+	printf("Usage: AssetPacker <output file> <folder or file>...\n");
+	printf("Packs every file in the folders (and the folders inside them) into one archive the game can mount.\n");
+	printf("Files are stored by the path you typed, so run it from the folder the game runs in, like:\n");
+	printf("    AssetPacker assets.pak Textures Shaders\n");
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		printUsage();
+		return 1;
+	}
+
+	std::string outputPath = argv[1];
+	AssetPacker packer;
+
+	for (int i = 2; i < argc; i++) {
+		fs::path input = argv[i];
+		if (fs::is_regular_file(input)) {
+			packer.addFile(input.generic_string(), input.string());
+		} else if (fs::is_directory(input)) {
+			for (auto& entry : fs::recursive_directory_iterator(input)) {
+				//Don't pack the archive into itself if it's being written inside one of the folders.
+				std::error_code error;
+				if (entry.is_regular_file() && !fs::equivalent(entry.path(), outputPath, error)) {
+					//generic_string gives forward slashes, the same as the paths we type in the game.
+					packer.addFile(entry.path().generic_string(), entry.path().string());
+				}
+			}
+		} else {
+			printf("%s isn't a file or a folder!\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (packer.write(outputPath) == false) {
+		return 1;
+	}
+
+	printf("Packed %d files into %s\n", packer.getNumFiles(), outputPath.c_str());
+	return 0;
+}
@@ -0,0 +1,224 @@
+#include "AtlasPacker.h"
+#include "PNGWriter.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+
+AtlasPacker::AtlasPacker(int maxPageSize, int padding, int extrude) :
+	_maxPageSize(maxPageSize),
+	_padding(padding),
+	_extrude(extrude)
+{
+}
+
+
+AtlasPacker::~AtlasPacker()
+{
+}
+
+void AtlasPacker::addImage(const std::string& name, const std::vector<unsigned char>& pixels, int width, int height) {
+	PackerImage image;
+	image.name = name;
+	image.pixels = pixels;
+	image.width = width;
+	image.height = height;
+	image.page = -1;
+	image.x = 0;
+	image.y = 0;
+	_images.push_back(image);
+}
+
+bool AtlasPacker::pack() {
+	_pageSizes.clear();
+
+	//Every image takes up its own size, plus the extrusion on both sides, plus padding on
+	//the right and bottom (the left and top of the page don't need any).
+	int border = _extrude * 2 + _padding;
+
+	//Tallest first, and by name when they tie so packing the same folder always gives the same sheet.
+	std::vector<PackerImage*> order;
+	for (auto& image : _images) {
+		if (image.width + border > _maxPageSize || image.height + border > _maxPageSize) {
+			printf("%s is %dx%d, which doesn't fit on a %dx%d page!\n", image.name.c_str(), image.width, image.height, _maxPageSize, _maxPageSize);
+			return false;
+		}
+		image.page = -1;
+		order.push_back(&image);
+	}
+	std::stable_sort(order.begin(), order.end(), [](const PackerImage* a, const PackerImage* b) {
+		if (a->height != b->height) return a->height > b->height;
+		return a->name < b->name;
+	});
+
+	//Fill one page at a time. Anything that didn't fit waits for the next page.
+	int placed = 0;
+	while (placed < (int)order.size()) {
+		int page = _pageSizes.size();
+		std::vector<SkylineNode> skyline;
+		skyline.push_back({ 0, 0, _maxPageSize });
+		int usedWidth = 0;
+		int usedHeight = 0;
+
+		for (auto image : order) {
+			if (image->page != -1) {
+				continue;
+			}
+			int width = image->width + border;
+			int height = image->height + border;
+			int x, y;
+			int index = findPosition(skyline, width, height, x, y);
+			if (index == -1) {
+				continue;
+			}
+			addSkylineNode(skyline, index, x, y, width, height);
+
+			image->page = page;
+			image->x = x + _extrude;
+			image->y = y + _extrude;
+			placed++;
+
+			//The padding after the last image on a row or column doesn't need to be on the page.
+			usedWidth = std::max(usedWidth, x + width - _padding);
+			usedHeight = std::max(usedHeight, y + height - _padding);
+		}
+
+		//Shrink the page down to the smallest power of two that still holds everything on it.
+		int pageWidth = 1;
+		while (pageWidth < usedWidth) pageWidth *= 2;
+		int pageHeight = 1;
+		while (pageHeight < usedHeight) pageHeight *= 2;
+		_pageSizes.emplace_back(pageWidth, pageHeight);
+	}
+
+	return true;
+}
+
+int AtlasPacker::findPosition(const std::vector<SkylineNode>& skyline, int width, int height, int& outX, int& outY) const {
+	int bestIndex = -1;
+	int bestY = INT_MAX;
+	int bestWidth = INT_MAX;
+
+	for (int i = 0; i < (int)skyline.size(); i++) {
+		int x = skyline[i].x;
+		if (x + width > _maxPageSize) {
+			break;
+		}
+
+		//The rectangle sits on the highest node it covers.
+		int y = 0;
+		int widthLeft = width;
+		for (int j = i; widthLeft > 0; j++) {
+			y = std::max(y, skyline[j].y);
+			widthLeft -= skyline[j].width;
+		}
+		if (y + height > _maxPageSize) {
+			continue;
+		}
+
+		//Lowest spot wins, and if two are just as low, the narrower node wastes less space.
+		if (y < bestY || (y == bestY && skyline[i].width < bestWidth)) {
+			bestIndex = i;
+			bestY = y;
+			bestWidth = skyline[i].width;
+			outX = x;
+			outY = y;
+		}
+	}
+
+	return bestIndex;
+}
+
+void AtlasPacker::addSkylineNode(std::vector<SkylineNode>& skyline, int index, int x, int y, int width, int height) const {
+	skyline.insert(skyline.begin() + index, { x, y + height, width });
+
+	//Whatever nodes the new one covers get cut short or removed.
+	for (int i = index + 1; i < (int)skyline.size(); i++) {
+		int coveredEnd = skyline[i - 1].x + skyline[i - 1].width;
+		if (skyline[i].x >= coveredEnd) {
+			break;
+		}
+		int shrink = coveredEnd - skyline[i].x;
+		skyline[i].x += shrink;
+		skyline[i].width -= shrink;
+		if (skyline[i].width > 0) {
+			break;
+		}
+		skyline.erase(skyline.begin() + i);
+		i--;
+	}
+
+	//Neighbours at the same height can become one node.
+	for (int i = 0; i + 1 < (int)skyline.size(); i++) {
+		if (skyline[i].y == skyline[i + 1].y) {
+			skyline[i].width += skyline[i + 1].width;
+			skyline.erase(skyline.begin() + i + 1);
+			i--;
+		}
+	}
+}
+
+void AtlasPacker::blitImage(std::vector<unsigned char>& page, int pageWidth, const PackerImage& image) const {
+	//Going over the extruded area too and clamping to the image's edge copies the edge pixels outwards.
+	for (int y = -_extrude; y < image.height + _extrude; y++) {
+		int sourceY = std::min(std::max(y, 0), image.height - 1);
+		for (int x = -_extrude; x < image.width + _extrude; x++) {
+			int sourceX = std::min(std::max(x, 0), image.width - 1);
+
+			const unsigned char* source = &image.pixels[(sourceY * image.width + sourceX) * 4];
+			unsigned char* dest = &page[((image.y + y) * pageWidth + image.x + x) * 4];
+			dest[0] = source[0];
+			dest[1] = source[1];
+			dest[2] = source[2];
+			dest[3] = source[3];
+		}
+	}
+}
+
+bool AtlasPacker::writePages(const std::string& outputPath) const {
+	for (int page = 0; page < (int)_pageSizes.size(); page++) {
+		int pageWidth = _pageSizes[page].first;
+		int pageHeight = _pageSizes[page].second;
+
+		std::string pagePath = outputPath;
+		if (_pageSizes.size() > 1) {
+			pagePath += "_" + std::to_string(page);
+		}
+
+		//The xml only wants the png's file name, since TextureAtlas looks for it next to the xml.
+		std::string imageName = pagePath + ".png";
+		size_t lastSlash = imageName.find_last_of("/\\");
+		if (lastSlash != std::string::npos) {
+			imageName = imageName.substr(lastSlash + 1);
+		}
+
+		//Fully transparent where there's no image.
+		std::vector<unsigned char> pixels(pageWidth * pageHeight * 4, 0);
+
+		std::ofstream xml(pagePath + ".xml");
+		if (xml.fail()) {
+			perror((pagePath + ".xml").c_str());
+			return false;
+		}
+		xml << "<TextureAtlas imagePath=\"" << imageName << "\">\n";
+
+		//Same order they were added in, so the xml comes out sorted if the input was.
+		for (auto& image : _images) {
+			if (image.page != page) {
+				continue;
+			}
+			blitImage(pixels, pageWidth, image);
+			xml << "\t<SubTexture name=\"" << image.name << "\" x=\"" << image.x << "\" y=\"" << image.y
+				<< "\" width=\"" << image.width << "\" height=\"" << image.height << "\"/>\n";
+		}
+		xml << "</TextureAtlas>";
+
+		if (writePNG(pagePath + ".png", pixels, pageWidth, pageHeight) == false) {
+			return false;
+		}
+		printf("Wrote %s (%dx%d)\n", (pagePath + ".png").c_str(), pageWidth, pageHeight);
+	}
+
+	return true;
+}
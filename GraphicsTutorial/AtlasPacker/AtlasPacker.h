@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+//One image going into the atlas. page, x and y get filled in by AtlasPacker::pack.
+struct PackerImage {
+	std::string name; //what the SubTexture gets called in the xml, like "Coin.png"
+	std::vector<unsigned char> pixels; //RGBA, rows from top to bottom
+	int width;
+	int height;
+
+	int page;
+	int x; //top left corner of the image on its page, not counting padding or extrusion
+	int y;
+};
+
+/*Packs a bunch of images into as few power of two sheets as it can, and writes each sheet out as
+a png with an xml next to it in the same TextureAtlas format as sprites.xml, so GameEngine::TextureAtlas
+can load them directly.
+
+It uses a skyline packer: we keep track of the top edge of everything placed so far (the "skyline")
+as a list of horizontal segments, and put each image at whichever spot keeps it lowest.
+Images are placed tallest first, which keeps the skyline fairly flat.
+
+Padding is empty space left between images, and extrude copies each image's edge pixels outwards
+that many times. Both stop linear filtering and mipmaps from bleeding neighbouring images into each other.*/
+
+class AtlasPacker
+{
+public:
+	AtlasPacker(int maxPageSize, int padding, int extrude);
+	~AtlasPacker();
+
+	void addImage(const std::string& name, const std::vector<unsigned char>& pixels, int width, int height);
+
+	//Works out where every image goes. Returns false (and says which one) if an image can't fit on an empty page.
+	bool pack();
+
+	//Writes outputPath.png and outputPath.xml, or outputPath_0.png, outputPath_1.png... if it needed more than one page.
+	bool writePages(const std::string& outputPath) const;
+
+	const std::vector<PackerImage>& getImages() const { return _images; }
+	int getNumPages() const { return _pageSizes.size(); }
+
+private:
+	//A horizontal piece of the skyline, starting at x and going width pixels to the right, at height y.
+	struct SkylineNode {
+		int x;
+		int y;
+		int width;
+	};
+
+	//Finds the spot that keeps a width x height rectangle lowest on the skyline.
+	//Returns the index of the node it starts on, or -1 if it doesn't fit.
+	int findPosition(const std::vector<SkylineNode>& skyline, int width, int height, int& outX, int& outY) const;
+	void addSkylineNode(std::vector<SkylineNode>& skyline, int index, int x, int y, int width, int height) const;
+
+	//Copies an image onto a page and smears its edges out into the extrusion border.
+	void blitImage(std::vector<unsigned char>& page, int pageWidth, const PackerImage& image) const;
+
+	int _maxPageSize;
+	int _padding;
+	int _extrude;
+
+	std::vector<PackerImage> _images;
+	std::vector<std::pair<int, int>> _pageSizes; //width and height of each page once they've been shrunk to fit
+};
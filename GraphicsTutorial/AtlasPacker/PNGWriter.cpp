@@ -0,0 +1,285 @@
+#include "PNGWriter.h"
+
+#include <cstdlib>
+#include <fstream>
+
+/*A png is an 8 byte signature followed by chunks (IHDR for the size, IDAT for the pixels,
+IEND to say we're done). The pixels are "filtered" one row at a time to make them easier to
+compress, and then compressed with deflate inside of a zlib stream. This only does what we
+need for atlas pages: 8 bit RGBA, deflate with the fixed huffman codes and simple LZ77 matching.
+That's not as small as a real png library would make them, but it's a lot smaller than no compression.*/
+
+namespace {
+
+	//Deflate packs bits starting from the lowest bit of each byte.
+	class BitWriter {
+	public:
+		BitWriter(std::vector<unsigned char>& out) : _out(out), _bitBuffer(0), _bitCount(0) {}
+
+		void writeBits(unsigned int bits, int count) {
+			_bitBuffer |= bits << _bitCount;
+			_bitCount += count;
+			while (_bitCount >= 8) {
+				_out.push_back(_bitBuffer & 0xFF);
+				_bitBuffer >>= 8;
+				_bitCount -= 8;
+			}
+		}
+
+		//Huffman codes are the one thing that is stored highest bit first, so we flip them around.
+		void writeHuffman(unsigned int code, int length) {
+			unsigned int reversed = 0;
+			for (int i = 0; i < length; i++) {
+				reversed |= ((code >> i) & 1) << (length - 1 - i);
+			}
+			writeBits(reversed, length);
+		}
+
+		void flush() {
+			if (_bitCount > 0) {
+				_out.push_back(_bitBuffer & 0xFF);
+			}
+			_bitBuffer = 0;
+			_bitCount = 0;
+		}
+
+	private:
+		std::vector<unsigned char>& _out;
+		unsigned int _bitBuffer;
+		int _bitCount;
+	};
+
+	const int LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const int LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const int DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const int DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	//The fixed huffman code for a literal byte or length symbol (0-287), from the deflate spec.
+	void writeFixedSymbol(BitWriter& writer, int symbol) {
+		if (symbol < 144) {
+			writer.writeHuffman(0x30 + symbol, 8);
+		} else if (symbol < 256) {
+			writer.writeHuffman(0x190 + symbol - 144, 9);
+		} else if (symbol < 280) {
+			writer.writeHuffman(symbol - 256, 7);
+		} else {
+			writer.writeHuffman(0xC0 + symbol - 280, 8);
+		}
+	}
+
+	void writeMatch(BitWriter& writer, int length, int distance) {
+		int code = 28;
+		while (LENGTH_BASE[code] > length) {
+			code--;
+		}
+		writeFixedSymbol(writer, 257 + code);
+		writer.writeBits(length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+		code = 29;
+		while (DISTANCE_BASE[code] > distance) {
+			code--;
+		}
+		//Distance codes are always 5 bits in a fixed huffman block.
+		writer.writeHuffman(code, 5);
+		writer.writeBits(distance - DISTANCE_BASE[code], DISTANCE_EXTRA[code]);
+	}
+
+	void deflate(std::vector<unsigned char>& out, const std::vector<unsigned char>& in) {
+		const int WINDOW_SIZE = 32768;
+		const int MIN_MATCH = 3;
+		const int MAX_MATCH = 258;
+		const int HASH_SIZE = 1 << 15;
+		const int MAX_CHAIN = 64; //how many earlier spots we check for a match before giving up
+
+		BitWriter writer(out);
+		//One block with the final flag set, using the fixed huffman codes (type 01).
+		writer.writeBits(1, 1);
+		writer.writeBits(1, 2);
+
+		//head has the last position each 3 byte hash was seen at, prev links back to the one before that.
+		std::vector<int> head(HASH_SIZE, -1);
+		std::vector<int> prev(in.size(), -1);
+		auto hashAt = [&in](size_t pos) {
+			return ((in[pos] << 10) ^ (in[pos + 1] << 5) ^ in[pos + 2]) & (HASH_SIZE - 1);
+		};
+		auto insert = [&](size_t pos) {
+			if (pos + MIN_MATCH <= in.size()) {
+				int hash = hashAt(pos);
+				prev[pos] = head[hash];
+				head[hash] = pos;
+			}
+		};
+
+		size_t pos = 0;
+		while (pos < in.size()) {
+			int bestLength = 0;
+			int bestDistance = 0;
+
+			if (pos + MIN_MATCH <= in.size()) {
+				int candidate = head[hashAt(pos)];
+				int maxLength = (in.size() - pos < MAX_MATCH) ? in.size() - pos : MAX_MATCH;
+				for (int chain = 0; candidate >= 0 && pos - candidate <= WINDOW_SIZE && chain < MAX_CHAIN; chain++) {
+					int length = 0;
+					while (length < maxLength && in[candidate + length] == in[pos + length]) {
+						length++;
+					}
+					if (length > bestLength) {
+						bestLength = length;
+						bestDistance = pos - candidate;
+						if (length == maxLength) {
+							break;
+						}
+					}
+					candidate = prev[candidate];
+				}
+			}
+
+			if (bestLength >= MIN_MATCH) {
+				writeMatch(writer, bestLength, bestDistance);
+				for (int i = 0; i < bestLength; i++) {
+					insert(pos + i);
+				}
+				pos += bestLength;
+			} else {
+				writeFixedSymbol(writer, in[pos]);
+				insert(pos);
+				pos++;
+			}
+		}
+
+		writeFixedSymbol(writer, 256); //end of block
+		writer.flush();
+	}
+
+	unsigned int crc32(const unsigned char* data, size_t size, unsigned int crc = 0xFFFFFFFF) {
+		static unsigned int table[256];
+		static bool tableReady = false;
+		if (!tableReady) {
+			for (unsigned int n = 0; n < 256; n++) {
+				unsigned int c = n;
+				for (int k = 0; k < 8; k++) {
+					c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+				}
+				table[n] = c;
+			}
+			tableReady = true;
+		}
+		for (size_t i = 0; i < size; i++) {
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc;
+	}
+
+	unsigned int adler32(const std::vector<unsigned char>& data) {
+		unsigned int a = 1, b = 0;
+		for (size_t i = 0; i < data.size(); i++) {
+			a = (a + data[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	void writeUint32(std::vector<unsigned char>& out, unsigned int value) {
+		out.push_back((value >> 24) & 0xFF);
+		out.push_back((value >> 16) & 0xFF);
+		out.push_back((value >> 8) & 0xFF);
+		out.push_back(value & 0xFF);
+	}
+
+	void writeChunk(std::ofstream& file, const char* type, const std::vector<unsigned char>& data) {
+		std::vector<unsigned char> chunk;
+		writeUint32(chunk, data.size());
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		//The crc covers the type and the data, but not the length.
+		writeUint32(chunk, crc32(&chunk[4], chunk.size() - 4) ^ 0xFFFFFFFF);
+		file.write((const char*)chunk.data(), chunk.size());
+	}
+
+	unsigned char paethPredictor(int a, int b, int c) {
+		int p = a + b - c;
+		int pa = std::abs(p - a);
+		int pb = std::abs(p - b);
+		int pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc) return a;
+		if (pb <= pc) return b;
+		return c;
+	}
+
+}
+
+bool writePNG(const std::string& filePath, const std::vector<unsigned char>& rgba, int width, int height) {
+	const int BYTES_PER_PIXEL = 4;
+	size_t rowSize = width * BYTES_PER_PIXEL;
+
+	//Every row starts with a byte saying which filter it used. We try all 5 and keep whichever
+	//one gives the smallest numbers (counting bytes as signed), which usually compresses best.
+	std::vector<unsigned char> filtered;
+	filtered.reserve((rowSize + 1) * height);
+	std::vector<unsigned char> candidate(rowSize);
+	std::vector<unsigned char> best(rowSize);
+
+	for (int y = 0; y < height; y++) {
+		const unsigned char* row = &rgba[y * rowSize];
+		const unsigned char* above = (y > 0) ? &rgba[(y - 1) * rowSize] : nullptr;
+
+		int bestFilter = 0;
+		unsigned long bestSum = ~0ul;
+		for (int filter = 0; filter < 5; filter++) {
+			unsigned long sum = 0;
+			for (size_t i = 0; i < rowSize; i++) {
+				int left = (i >= BYTES_PER_PIXEL) ? row[i - BYTES_PER_PIXEL] : 0;
+				int up = above ? above[i] : 0;
+				int upLeft = (above && i >= BYTES_PER_PIXEL) ? above[i - BYTES_PER_PIXEL] : 0;
+
+				int predicted = 0;
+				switch (filter) {
+					case 1: predicted = left; break;
+					case 2: predicted = up; break;
+					case 3: predicted = (left + up) / 2; break;
+					case 4: predicted = paethPredictor(left, up, upLeft); break;
+				}
+				candidate[i] = (unsigned char)(row[i] - predicted);
+				sum += (candidate[i] < 128) ? candidate[i] : 256 - candidate[i];
+			}
+			if (sum < bestSum) {
+				bestSum = sum;
+				bestFilter = filter;
+				best.swap(candidate);
+			}
+		}
+
+		filtered.push_back(bestFilter);
+		filtered.insert(filtered.end(), best.begin(), best.end());
+	}
+
+	//zlib wraps the deflate data with a 2 byte header and an adler32 checksum of the uncompressed data.
+	std::vector<unsigned char> idat;
+	idat.push_back(0x78);
+	idat.push_back(0x01);
+	deflate(idat, filtered);
+	writeUint32(idat, adler32(filtered));
+
+	std::vector<unsigned char> ihdr;
+	writeUint32(ihdr, width);
+	writeUint32(ihdr, height);
+	ihdr.push_back(8); //bit depth
+	ihdr.push_back(6); //color type 6 = RGBA
+	ihdr.push_back(0); //compression method, deflate is the only one
+	ihdr.push_back(0); //filter method
+	ihdr.push_back(0); //no interlacing
+
+	std::ofstream file(filePath, std::ios::binary);
+	if (file.fail()) {
+		perror(filePath.c_str());
+		return false;
+	}
+
+	const unsigned char SIGNATURE[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	file.write((const char*)SIGNATURE, 8);
+	writeChunk(file, "IHDR", ihdr);
+	writeChunk(file, "IDAT", idat);
+	writeChunk(file, "IEND", std::vector<unsigned char>());
+
+	return !file.fail();
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+//picoPNG can only read pngs, so the packer needs its own way to write them.
+//rgba is 4 bytes per pixel, rows from top to bottom, the same layout decodePNG gives us.
+//Returns false if the file couldn't be written.
+bool writePNG(const std::string& filePath, const std::vector<unsigned char>& rgba, int width, int height);
@@ -0,0 +1,102 @@
+#include <GameEngine\MappedFile.h>
+#include <GameEngine\picoPNG.h>
+
+#include "AtlasPacker.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+void printUsage() {
+	printf("Usage: AtlasPacker <input folder> <output name> [--max-size 2048] [--padding 2] [--extrude 1]\n");
+	printf("Packs every png in the input folder (and the folders inside it) into output name.png and output name.xml.\n");
+	printf("If they don't all fit on one page you get output name_0.png, output name_1.png and so on.\n");
+}
+
+int main(int argc, char** argv) {
+	if (argc < 3) {
+		printUsage();
+		return 1;
+	}
+
+	std::string inputDir = argv[1];
+	std::string outputPath = argv[2];
+	int maxPageSize = 2048;
+	int padding = 2;
+	int extrude = 1;
+
+	for (int i = 3; i < argc; i++) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			printUsage();
+			return 1;
+		}
+		int value = atoi(argv[++i]);
+		if (arg == "--max-size") {
+			maxPageSize = value;
+		} else if (arg == "--padding") {
+			padding = value;
+		} else if (arg == "--extrude") {
+			extrude = value;
+		} else {
+			printf("Unknown option %s\n", arg.c_str());
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (fs::is_directory(inputDir) == false) {
+		printf("%s isn't a folder!\n", inputDir.c_str());
+		return 1;
+	}
+
+	//The directory iterator doesn't promise any order, so we sort the paths to get the same atlas every time.
+	std::vector<fs::path> files;
+	for (auto& entry : fs::recursive_directory_iterator(inputDir)) {
+		if (entry.is_regular_file() && entry.path().extension() == ".png") {
+			files.push_back(entry.path());
+		}
+	}
+	std::sort(files.begin(), files.end());
+
+	if (files.empty()) {
+		printf("There aren't any pngs in %s\n", inputDir.c_str());
+		return 1;
+	}
+
+	AtlasPacker packer(maxPageSize, padding, extrude);
+
+	GameEngine::MappedFile in;
+	std::vector<unsigned char> out;
+	unsigned long width, height;
+	for (auto& file : files) {
+		if (in.open(file.string()) == false || in.size() == 0) {
+			printf("Failed to read %s\n", file.string().c_str());
+			return 1;
+		}
+
+		int errorCode = GameEngine::decodePNG(out, width, height, in.data(), (size_t)in.size());
+		if (errorCode != 0) {
+			printf("decodePNG failed on %s with error: %d\n", file.string().c_str(), errorCode);
+			return 1;
+		}
+
+		//Names are the path inside of the input folder, so the top level ones are just "Coin.png" like in sprites.xml.
+		packer.addImage(fs::relative(file, inputDir).generic_string(), out, width, height);
+	}
+
+	if (packer.pack() == false) {
+		return 1;
+	}
+	if (packer.writePages(outputPath) == false) {
+		return 1;
+	}
+
+	printf("Packed %d images onto %d page(s)\n", (int)files.size(), packer.getNumPages());
+	return 0;
+}
@@ -0,0 +1,134 @@
+#include "AssetArchive.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace GameEngine {
+
+	namespace {
+
+		//'\' becomes '/' and A-Z becomes a-z, so both ways of writing a path end up the same.
+		char normalize(char c) {
+			if (c == '\\') return '/';
+			if (c >= 'A' && c <= 'Z') return c - 'A' + 'a';
+			return c;
+		}
+
+	}
+
+	AssetArchive::AssetArchive() :
+		_header(nullptr),
+		_slots(nullptr),
+		_names(nullptr)
+	{
+	}
+
+
+	AssetArchive::~AssetArchive()
+	{
+	}
+
+	bool AssetArchive::open(const std::string& archivePath) {
+		close();
+		if (_file.open(archivePath) == false) {
+			return false;
+		}
+
+		const unsigned char* data = _file.data();
+		uint64_t size = _file.size();
+
+		//Check everything up front, then find never has to worry about reading past the end.
+		const AssetArchiveHeader* header = (const AssetArchiveHeader*)data;
+		bool valid = size >= sizeof(AssetArchiveHeader) &&
+			memcmp(header->magic, "GPAK", 4) == 0 &&
+			header->version == VERSION &&
+			header->numSlots != 0 && (header->numSlots & (header->numSlots - 1)) == 0 &&
+			//The packer keeps the table at most half full. A full table would make find loop forever on a miss.
+			(uint64_t)header->numFiles * 2 <= header->numSlots &&
+			header->slotsOffset % alignof(AssetArchiveSlot) == 0 &&
+			header->slotsOffset <= size && (size - header->slotsOffset) / sizeof(AssetArchiveSlot) >= header->numSlots &&
+			header->namesOffset <= size;
+
+		if (valid) {
+			const AssetArchiveSlot* slots = (const AssetArchiveSlot*)(data + header->slotsOffset);
+			uint64_t namesSize = size - header->namesOffset;
+			uint32_t numUsed = 0;
+			for (uint32_t i = 0; i < header->numSlots && valid; i++) {
+				if (slots[i].hash == 0) continue;
+				numUsed++;
+				valid = (uint64_t)slots[i].nameOffset + slots[i].nameLength <= namesSize &&
+					slots[i].dataOffset <= size && slots[i].dataSize <= size - slots[i].dataOffset;
+			}
+			//numFiles could be lying, so count the used slots ourselves.
+			valid = valid && numUsed == header->numFiles;
+		}
+
+		if (!valid) {
+			printf("%s isn't an asset archive, or it's from a different version of AssetPacker.\n", archivePath.c_str());
+			_file.close();
+			return false;
+		}
+
+		_header = header;
+		_slots = (const AssetArchiveSlot*)(data + header->slotsOffset);
+		_names = (const char*)(data + header->namesOffset);
+		return true;
+	}
+
+	void AssetArchive::close() {
+		_file.close();
+		_header = nullptr;
+		_slots = nullptr;
+		_names = nullptr;
+	}
+
+	bool AssetArchive::find(std::string_view filePath, const unsigned char*& data, uint64_t& size) const {
+		if (_header == nullptr) {
+			return false;
+		}
+
+		//Open addressing: start at the slot the hash picks and walk forward until we find it
+		//or hit an empty slot. The packer keeps the table at most half full, so this is short.
+		uint64_t hash = hashPath(filePath);
+		uint32_t mask = _header->numSlots - 1;
+		for (uint32_t i = (uint32_t)hash & mask; _slots[i].hash != 0; i = (i + 1) & mask) {
+			const AssetArchiveSlot& slot = _slots[i];
+			if (slot.hash == hash && pathsMatch(filePath, std::string_view(_names + slot.nameOffset, slot.nameLength))) {
+				data = _file.data() + slot.dataOffset;
+				size = slot.dataSize;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::string_view AssetArchive::getPath(int slot) const {
+		if (_slots[slot].hash == 0) {
+			return std::string_view();
+		}
+		return std::string_view(_names + _slots[slot].nameOffset, _slots[slot].nameLength);
+	}
+
+	uint64_t AssetArchive::hashPath(std::string_view filePath) {
+		//64 bit FNV-1a, it's tiny and good enough for a few thousand paths.
+		uint64_t hash = 14695981039346656037ull;
+		for (char c : filePath) {
+			hash ^= (unsigned char)normalize(c);
+			hash *= 1099511628211ull;
+		}
+		return hash == 0 ? 1 : hash;
+	}
+
+	bool AssetArchive::pathsMatch(std::string_view a, std::string_view b) {
+		if (a.size() != b.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < a.size(); i++) {
+			if (normalize(a[i]) != normalize(b[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+}
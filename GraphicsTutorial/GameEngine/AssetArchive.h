@@ -0,0 +1,75 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace GameEngine {
+
+	/*An asset archive is a lot of files packed into one big file (AssetPacker makes them),
+	so starting the game opens one file instead of a couple hundred. The whole archive gets
+	mapped into memory once, and after that "opening" a file inside of it is just finding
+	where its bytes start.
+
+	The layout, all numbers little endian:
+	AssetArchiveHeader
+	AssetArchiveSlot * numSlots - a hash table of every file, looked up by path
+	the names of every file, one after the other with nothing in between
+	the files themselves, each one starting on a multiple of DATA_ALIGNMENT bytes,
+	in the same order as their names sorted, so reading them all goes front to back.
+
+	Paths are matched the way windows matches them: '\' is the same as '/', and upper and
+	lower case are the same. So "Textures/Coin.png" finds "textures\coin.png".*/
+
+	struct AssetArchiveHeader {
+		char magic[4]; //always "GPAK"
+		uint32_t version;
+		uint32_t numFiles;
+		uint32_t numSlots; //always a power of two, so hash & (numSlots - 1) picks a slot
+		uint64_t slotsOffset;
+		uint64_t namesOffset;
+	};
+
+	struct AssetArchiveSlot {
+		uint64_t hash; //0 means nothing is in this slot
+		uint64_t dataOffset;
+		uint64_t dataSize;
+		uint32_t nameOffset; //from the start of the names
+		uint32_t nameLength;
+	};
+
+	class AssetArchive
+	{
+	public:
+		static const uint32_t VERSION = 1;
+		static const uint64_t DATA_ALIGNMENT = 16;
+
+		AssetArchive();
+		~AssetArchive();
+
+		//Maps the archive and checks that it's one of ours. Prints what's wrong and returns false if it isn't.
+		bool open(const std::string& archivePath);
+		void close();
+
+		//Points data at the file's bytes inside of the archive. They're good until the archive is closed.
+		bool find(std::string_view filePath, const unsigned char*& data, uint64_t& size) const;
+
+		//For going through every file. Slots that are empty give back an empty path.
+		int getNumSlots() const { return _header ? _header->numSlots : 0; }
+		std::string_view getPath(int slot) const;
+
+		//Hashes the path the same way find does, with '\' turned into '/' and everything lower case.
+		//Never returns 0, so 0 can mean an empty slot.
+		static uint64_t hashPath(std::string_view filePath);
+		static bool pathsMatch(std::string_view a, std::string_view b);
+
+	private:
+		MappedFile _file;
+		const AssetArchiveHeader* _header;
+		const AssetArchiveSlot* _slots;
+		const char* _names;
+	};
+
+}
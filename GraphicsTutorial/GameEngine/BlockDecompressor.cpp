@@ -0,0 +1,328 @@
+#include "BlockDecompressor.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace GameEngine {
+
+	namespace {
+
+		//How each BC7 mode lays out its bits.
+		struct BC7Mode {
+			int numSubsets; //how many pairs of endpoints the block has
+			int partitionBits; //which of the 64 partitions says what pixel uses what pair
+			int rotationBits; //modes 4 and 5 can swap alpha with one of the colors
+			int indexSelectionBits; //mode 4 can swap which indices go with color and alpha
+			int colorBits;
+			int alphaBits; //0 means alpha is always 255
+			int endpointPBits; //1 means every endpoint gets an extra low bit
+			int sharedPBits; //1 means every pair of endpoints shares an extra low bit
+			int indexBits;
+			int indexBits2; //modes 4 and 5 have a second set of indices, for alpha
+		};
+
+		const BC7Mode BC7_MODES[8] = {
+			{ 3, 4, 0, 0, 4, 0, 1, 0, 3, 0 },
+			{ 2, 6, 0, 0, 6, 0, 0, 1, 3, 0 },
+			{ 3, 6, 0, 0, 5, 0, 0, 0, 2, 0 },
+			{ 2, 6, 0, 0, 7, 0, 1, 0, 2, 0 },
+			{ 1, 0, 2, 1, 5, 6, 0, 0, 2, 3 },
+			{ 1, 0, 2, 0, 7, 8, 0, 0, 2, 2 },
+			{ 1, 0, 0, 0, 7, 7, 1, 0, 4, 0 },
+			{ 2, 6, 0, 0, 5, 5, 1, 0, 2, 0 }
+		};
+
+		//Which subset each pixel is in for the 2 subset partitions, one bit per pixel (pixel 0 is the lowest bit).
+		const uint16_t BC7_PARTITIONS_2[64] = {
+			0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80,
+			0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+			0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce,
+			0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+			0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a,
+			0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+			0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c,
+			0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22
+		};
+
+		//Same thing for 3 subsets, two bits per pixel.
+		const uint32_t BC7_PARTITIONS_3[64] = {
+			0xaa685050, 0x6a5a5040, 0x5a5a4200, 0x5450a0a8, 0xa5a50000, 0xa0a05050, 0x5555a0a0, 0x5a5a5050,
+			0xaa550000, 0xaa555500, 0xaaaa5500, 0x90909090, 0x94949494, 0xa4a4a4a4, 0xa9a59450, 0x2a0a4250,
+			0xa5945040, 0x0a425054, 0xa5a5a500, 0x55a0a0a0, 0xa8a85454, 0x6a6a4040, 0xa4a45000, 0x1a1a0500,
+			0x0050a4a4, 0xaaa59090, 0x14696914, 0x69691400, 0xa08585a0, 0xaa821414, 0x50a4a450, 0x6a5a0200,
+			0xa9a58000, 0x5090a0a8, 0xa8a09050, 0x24242424, 0x00aa5500, 0x24924924, 0x24499224, 0x50a50a50,
+			0x500aa550, 0xaaaa4444, 0x66660000, 0xa5a0a5a0, 0x50a050a0, 0x69286928, 0x44aaaa44, 0x66666600,
+			0xaa444444, 0x54a854a8, 0x95809580, 0x96969600, 0xa85454a8, 0x80959580, 0xaa141414, 0x96960000,
+			0xaaaa1414, 0xa05050a0, 0xa0a5a5a0, 0x96000000, 0x40804080, 0xa9a8a9a8, 0xaaaaaa44, 0x2a4a5254
+		};
+
+		//The anchor pixel of each subset has one less index bit (its top bit is always 0).
+		//Subset 0's anchor is always pixel 0, these are the others.
+		const unsigned char BC7_ANCHORS_2[64] = {
+			15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+			15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2, 8, 8, 2, 2,
+			15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6,
+			6, 2, 6, 8, 15, 15, 2, 2, 15, 15, 15, 15, 15, 2, 2, 15
+		};
+		const unsigned char BC7_ANCHORS_3_SECOND[64] = {
+			3, 3, 15, 15, 8, 3, 15, 15, 8, 8, 6, 6, 6, 5, 3, 3,
+			3, 3, 8, 15, 3, 3, 6, 10, 5, 8, 8, 6, 8, 5, 15, 15,
+			8, 15, 3, 5, 6, 10, 8, 15, 15, 3, 15, 5, 15, 15, 15, 15,
+			3, 15, 5, 5, 5, 8, 5, 10, 5, 10, 8, 13, 15, 12, 3, 3
+		};
+		const unsigned char BC7_ANCHORS_3_THIRD[64] = {
+			15, 8, 8, 3, 15, 15, 3, 8, 15, 15, 15, 15, 15, 15, 15, 8,
+			15, 8, 15, 3, 15, 8, 15, 8, 3, 15, 6, 10, 15, 15, 10, 8,
+			15, 3, 15, 10, 10, 8, 9, 10, 6, 15, 8, 15, 3, 6, 6, 8,
+			15, 3, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 3, 15, 15, 8
+		};
+
+		//How far from endpoint 0 to endpoint 1 each index is, out of 64.
+		const int BC7_WEIGHTS_2[4] = { 0, 21, 43, 64 };
+		const int BC7_WEIGHTS_3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+		const int BC7_WEIGHTS_4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		//Reads a block's bits from lowest to highest.
+		class BitReader {
+		public:
+			BitReader(const unsigned char* block) : _position(0) {
+				memcpy(&_low, block, 8);
+				memcpy(&_high, block + 8, 8);
+			}
+
+			unsigned int read(int numBits) {
+				if (numBits == 0) {
+					return 0;
+				}
+				uint64_t value;
+				if (_position >= 64) {
+					value = _high >> (_position - 64);
+				} else if (_position + numBits <= 64) {
+					value = _low >> _position;
+				} else {
+					//It's split between the two halves.
+					value = (_low >> _position) | (_high << (64 - _position));
+				}
+				_position += numBits;
+				return (unsigned int)(value & ((1u << numBits) - 1));
+			}
+
+		private:
+			uint64_t _low;
+			uint64_t _high;
+			int _position;
+		};
+
+		//Turns a numBits value into 0-255 by repeating its top bits at the bottom, so the biggest value is 255.
+		unsigned char expandBits(unsigned int value, int numBits) {
+			value <<= (8 - numBits);
+			return (unsigned char)(value | (value >> numBits));
+		}
+
+		const int* getWeights(int indexBits) {
+			return indexBits == 2 ? BC7_WEIGHTS_2 : (indexBits == 3 ? BC7_WEIGHTS_3 : BC7_WEIGHTS_4);
+		}
+
+		unsigned char interpolate(int e0, int e1, int weight) {
+			return (unsigned char)(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+		}
+
+		//Fills in the 4 colors of a BC1 color block. BC3 always uses 4 colors, so it passes false for allowThreeColors.
+		void decodeBC1Palette(const unsigned char* block, unsigned char palette[4][4], bool allowThreeColors) {
+			unsigned int c0 = block[0] | (block[1] << 8);
+			unsigned int c1 = block[2] | (block[3] << 8);
+
+			//The endpoints are 5 bits red, 6 bits green, 5 bits blue.
+			palette[0][0] = expandBits(c0 >> 11, 5);
+			palette[0][1] = expandBits((c0 >> 5) & 0x3F, 6);
+			palette[0][2] = expandBits(c0 & 0x1F, 5);
+			palette[0][3] = 255;
+			palette[1][0] = expandBits(c1 >> 11, 5);
+			palette[1][1] = expandBits((c1 >> 5) & 0x3F, 6);
+			palette[1][2] = expandBits(c1 & 0x1F, 5);
+			palette[1][3] = 255;
+
+			if (c0 > c1 || !allowThreeColors) {
+				for (int c = 0; c < 3; c++) {
+					palette[2][c] = (unsigned char)((2 * palette[0][c] + palette[1][c]) / 3);
+					palette[3][c] = (unsigned char)((palette[0][c] + 2 * palette[1][c]) / 3);
+				}
+				palette[2][3] = 255;
+				palette[3][3] = 255;
+			} else {
+				//Putting the endpoints the "wrong" way around means a halfway color and see through black.
+				for (int c = 0; c < 3; c++) {
+					palette[2][c] = (unsigned char)((palette[0][c] + palette[1][c]) / 2);
+					palette[3][c] = 0;
+				}
+				palette[2][3] = 255;
+				palette[3][3] = 0;
+			}
+		}
+
+	}
+
+	void BlockDecompressor::decodeBC1(const unsigned char* block, unsigned char* pixels, bool punchThroughAlpha) {
+		unsigned char palette[4][4];
+		decodeBC1Palette(block, palette, true);
+		if (!punchThroughAlpha) {
+			palette[3][3] = 255;
+		}
+
+		//Then 2 bits per pixel pick one of the 4 colors.
+		uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+		for (int i = 0; i < 16; i++) {
+			memcpy(pixels + i * 4, palette[(indices >> (2 * i)) & 3], 4);
+		}
+	}
+
+	void BlockDecompressor::decodeBC3(const unsigned char* block, unsigned char* pixels) {
+		unsigned char palette[4][4];
+		decodeBC1Palette(block + 8, palette, false);
+
+		//The alpha works the same way as the color, two endpoints and 8 values between them, 3 bits per pixel.
+		int alphas[8];
+		alphas[0] = block[0];
+		alphas[1] = block[1];
+		if (alphas[0] > alphas[1]) {
+			for (int i = 2; i < 8; i++) {
+				alphas[i] = ((8 - i) * alphas[0] + (i - 1) * alphas[1]) / 7;
+			}
+		} else {
+			//Same trick as BC1, backwards endpoints means fewer steps, plus fully see through and fully solid.
+			for (int i = 2; i < 6; i++) {
+				alphas[i] = ((6 - i) * alphas[0] + (i - 1) * alphas[1]) / 5;
+			}
+			alphas[6] = 0;
+			alphas[7] = 255;
+		}
+
+		uint64_t alphaIndices = 0;
+		for (int i = 0; i < 6; i++) {
+			alphaIndices |= (uint64_t)block[2 + i] << (8 * i);
+		}
+		uint32_t colorIndices = block[12] | (block[13] << 8) | (block[14] << 16) | ((uint32_t)block[15] << 24);
+		for (int i = 0; i < 16; i++) {
+			memcpy(pixels + i * 4, palette[(colorIndices >> (2 * i)) & 3], 3);
+			pixels[i * 4 + 3] = (unsigned char)alphas[(alphaIndices >> (3 * i)) & 7];
+		}
+	}
+
+	void BlockDecompressor::decodeBC7(const unsigned char* block, unsigned char* pixels) {
+		BitReader bits(block);
+
+		//The mode is however many 0 bits come before the first 1.
+		int mode = 0;
+		while (mode < 8 && bits.read(1) == 0) {
+			mode++;
+		}
+		if (mode == 8) {
+			//Not a real block, these decode to see through black.
+			memset(pixels, 0, 64);
+			return;
+		}
+		const BC7Mode& m = BC7_MODES[mode];
+
+		int partition = bits.read(m.partitionBits);
+		int rotation = bits.read(m.rotationBits);
+		int indexSelection = bits.read(m.indexSelectionBits);
+
+		//All of the reds come first, then all of the greens, and so on.
+		int numEndpoints = m.numSubsets * 2;
+		int endpoints[6][4];
+		for (int c = 0; c < 3; c++) {
+			for (int e = 0; e < numEndpoints; e++) {
+				endpoints[e][c] = bits.read(m.colorBits);
+			}
+		}
+		for (int e = 0; e < numEndpoints; e++) {
+			endpoints[e][3] = bits.read(m.alphaBits);
+		}
+
+		int colorBits = m.colorBits;
+		int alphaBits = m.alphaBits;
+		if (m.endpointPBits || m.sharedPBits) {
+			int pBits[6];
+			if (m.endpointPBits) {
+				for (int e = 0; e < numEndpoints; e++) {
+					pBits[e] = bits.read(1);
+				}
+			} else {
+				for (int s = 0; s < m.numSubsets; s++) {
+					pBits[s * 2] = pBits[s * 2 + 1] = bits.read(1);
+				}
+			}
+			for (int e = 0; e < numEndpoints; e++) {
+				for (int c = 0; c < 4; c++) {
+					endpoints[e][c] = (endpoints[e][c] << 1) | pBits[e];
+				}
+			}
+			colorBits++;
+			if (alphaBits > 0) {
+				alphaBits++;
+			}
+		}
+
+		for (int e = 0; e < numEndpoints; e++) {
+			for (int c = 0; c < 3; c++) {
+				endpoints[e][c] = expandBits(endpoints[e][c], colorBits);
+			}
+			endpoints[e][3] = alphaBits > 0 ? expandBits(endpoints[e][3], alphaBits) : 255;
+		}
+
+		int subsets[16];
+		for (int i = 0; i < 16; i++) {
+			if (m.numSubsets == 1) {
+				subsets[i] = 0;
+			} else if (m.numSubsets == 2) {
+				subsets[i] = (BC7_PARTITIONS_2[partition] >> i) & 1;
+			} else {
+				subsets[i] = (BC7_PARTITIONS_3[partition] >> (2 * i)) & 3;
+			}
+		}
+
+		int indices[16];
+		for (int i = 0; i < 16; i++) {
+			bool anchor = i == 0 ||
+				(m.numSubsets == 2 && i == BC7_ANCHORS_2[partition]) ||
+				(m.numSubsets == 3 && (i == BC7_ANCHORS_3_SECOND[partition] || i == BC7_ANCHORS_3_THIRD[partition]));
+			indices[i] = bits.read(anchor ? m.indexBits - 1 : m.indexBits);
+		}
+		int indices2[16];
+		if (m.indexBits2 > 0) {
+			for (int i = 0; i < 16; i++) {
+				indices2[i] = bits.read(i == 0 ? m.indexBits2 - 1 : m.indexBits2);
+			}
+		}
+
+		for (int i = 0; i < 16; i++) {
+			const int* e0 = endpoints[subsets[i] * 2];
+			const int* e1 = endpoints[subsets[i] * 2 + 1];
+			unsigned char* pixel = pixels + i * 4;
+
+			int colorWeight, alphaWeight;
+			if (m.indexBits2 == 0) {
+				colorWeight = alphaWeight = getWeights(m.indexBits)[indices[i]];
+			} else if (indexSelection == 0) {
+				colorWeight = getWeights(m.indexBits)[indices[i]];
+				alphaWeight = getWeights(m.indexBits2)[indices2[i]];
+			} else {
+				colorWeight = getWeights(m.indexBits2)[indices2[i]];
+				alphaWeight = getWeights(m.indexBits)[indices[i]];
+			}
+
+			for (int c = 0; c < 3; c++) {
+				pixel[c] = interpolate(e0[c], e1[c], colorWeight);
+			}
+			pixel[3] = interpolate(e0[3], e1[3], alphaWeight);
+
+			//Rotation 1, 2 and 3 mean alpha was stored where red, green or blue goes.
+			if (rotation > 0) {
+				unsigned char swap = pixel[3];
+				pixel[3] = pixel[rotation - 1];
+				pixel[rotation - 1] = swap;
+			}
+		}
+	}
+
+}
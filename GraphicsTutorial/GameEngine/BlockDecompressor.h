@@ -0,0 +1,23 @@
+#pragma once
+
+namespace GameEngine {
+
+	/*Block compressed textures (BC1, BC3 and BC7, also known as DXT1, DXT5 and BPTC) store the
+	image as 4x4 blocks of pixels, 8 or 16 bytes each, and the gpu decodes them while it draws.
+	If the driver doesn't support one of those formats (software openGL usually doesn't have BC7),
+	we decode the blocks here instead and upload plain RGBA.
+
+	Each function decodes one block into 16 RGBA pixels (64 bytes), row by row.*/
+
+	class BlockDecompressor
+	{
+	public:
+		//8 bytes. If punchThroughAlpha is true, blocks that use 3 colors have see through black as their 4th.
+		static void decodeBC1(const unsigned char* block, unsigned char* pixels, bool punchThroughAlpha = true);
+		//16 bytes: 8 bytes of alpha, then a BC1 block for the color.
+		static void decodeBC3(const unsigned char* block, unsigned char* pixels);
+		//16 bytes, with 8 different ways (modes) of packing the block.
+		static void decodeBC7(const unsigned char* block, unsigned char* pixels);
+	};
+
+}
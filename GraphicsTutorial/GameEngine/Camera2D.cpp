@@ -69,4 +69,11 @@ namespace GameEngine {
 		screenCoords += _position;
 		return screenCoords;
 	}
+
+	glm::vec4 Camera2D::getVisibleRect() const {
+		//The screen is centered on _position, and zooming in (bigger _scale) shows less of the world.
+		glm::vec2 size = glm::vec2(_screenWidth, _screenHeight) / _scale;
+		glm::vec2 bottomLeft = _position - size / 2.0f;
+		return glm::vec4(bottomLeft, size);
+	}
 }
@@ -19,6 +19,11 @@ namespace GameEngine {
 
 		glm::vec2 convertScreenToWorld(glm::vec2 screenCoords);
 
+		//The part of the world that's on screen, as x, y, width, height (the same as a sprite's destRect).
+		//It's convertScreenToWorld for the corners of the screen, so it follows _position and _scale.
+		//Give it to SpriteBatch::setCullRect so sprites that can't be seen are thrown away early.
+		glm::vec4 getVisibleRect() const;
+
 		//setters
 		//Anytime we set the position or scale again, we need to update our _cameraMatrix
 		void setPosition(glm::vec2& newPosition) { _position = newPosition; _needsMatrixUpdate = true; } 
@@ -0,0 +1,304 @@
+#include "CompressedImageLoader.h"
+#include "BlockDecompressor.h"
+#include "MipmapBuilder.h"
+#include "AssetArchive.h"
+
+#include <cstring>
+
+namespace GameEngine {
+
+	namespace {
+
+		//Every .ktx (version 1) file starts with these 12 bytes.
+		const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+		struct KTXHeader {
+			unsigned char identifier[12];
+			uint32_t endianness; //0x04030201 if the file was written little endian, like ours
+			uint32_t glType; //0 for compressed formats
+			uint32_t glTypeSize;
+			uint32_t glFormat;
+			uint32_t glInternalFormat; //the GL_COMPRESSED_ format
+			uint32_t glBaseInternalFormat;
+			uint32_t pixelWidth;
+			uint32_t pixelHeight;
+			uint32_t pixelDepth; //0 for 2D textures
+			uint32_t numberOfArrayElements; //0 if it isn't an array
+			uint32_t numberOfFaces; //6 for cube maps
+			uint32_t numberOfMipmapLevels; //0 means "make them yourself"
+			uint32_t bytesOfKeyValueData; //extra information we skip over
+		};
+
+		//A .dds file is "DDS " and then this.
+		struct DDSHeader {
+			uint32_t size; //always 124
+			uint32_t flags;
+			uint32_t height;
+			uint32_t width;
+			uint32_t pitchOrLinearSize;
+			uint32_t depth;
+			uint32_t mipMapCount;
+			uint32_t reserved1[11];
+			//The pixel format
+			uint32_t pfSize;
+			uint32_t pfFlags;
+			char pfFourCC[4]; //"DXT1", "DXT5", or "DX10" if a DDSHeaderDX10 comes next
+			uint32_t pfRGBBitCount;
+			uint32_t pfMasks[4];
+			uint32_t caps;
+			uint32_t caps2;
+			uint32_t caps3;
+			uint32_t caps4;
+			uint32_t reserved2;
+		};
+
+		//Newer formats (like BC7) don't have a FourCC, they come after the header as a DXGI format instead.
+		struct DDSHeaderDX10 {
+			uint32_t dxgiFormat;
+			uint32_t resourceDimension; //3 means a 2D texture
+			uint32_t miscFlag;
+			uint32_t arraySize;
+			uint32_t miscFlags2;
+		};
+
+		const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+		const uint32_t DDPF_FOURCC = 0x4;
+		const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+		const uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+		const uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+		const uint32_t DXGI_FORMAT_BC1_UNORM = 71;
+		const uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+		const uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+
+		bool isKnownFormat(GLenum format) {
+			return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT ||
+				format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ||
+				format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT ||
+				format == GL_COMPRESSED_RGBA_BPTC_UNORM;
+		}
+
+		//Checks the size and number of levels make sense before we trust them.
+		bool checkSize(DecodedImage& image, uint32_t numLevels, std::string& error) {
+			if (image.width == 0 || image.height == 0 || image.width > 16384 || image.height > 16384) {
+				error = "Bad texture size " + std::to_string(image.width) + "x" + std::to_string(image.height);
+				return false;
+			}
+			if (numLevels > (uint32_t)MipmapBuilder::getNumLevels(image.width, image.height)) {
+				error = "More mipmaps than a " + std::to_string(image.width) + "x" + std::to_string(image.height) + " texture can have";
+				return false;
+			}
+			image.numLevels = numLevels > 0 ? numLevels : 1;
+			return true;
+		}
+
+	}
+
+	bool CompressedImageLoader::isCompressedFile(std::string_view filePath) {
+		if (filePath.size() < 4) {
+			return false;
+		}
+		std::string_view extension = filePath.substr(filePath.size() - 4);
+		return AssetArchive::pathsMatch(extension, ".ktx") || AssetArchive::pathsMatch(extension, ".dds");
+	}
+
+	bool CompressedImageLoader::load(const unsigned char* data, uint64_t size, DecodedImage& image, std::string& error) {
+		if (size >= sizeof(KTX_IDENTIFIER) && memcmp(data, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) == 0) {
+			return loadKTX(data, size, image, error);
+		}
+		if (size >= 4 && memcmp(data, "DDS ", 4) == 0) {
+			return loadDDS(data, size, image, error);
+		}
+		error = "Not a .ktx or .dds file";
+		return false;
+	}
+
+	bool CompressedImageLoader::isSupported(GLenum format) {
+		switch (format) {
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+				return GLEW_EXT_texture_compression_s3tc == GL_TRUE;
+			case GL_COMPRESSED_RGBA_BPTC_UNORM:
+				return GLEW_ARB_texture_compression_bptc == GL_TRUE || GLEW_VERSION_4_2 == GL_TRUE;
+			default:
+				return false;
+		}
+	}
+
+	void CompressedImageLoader::decompress(const DecodedImage& compressed, DecodedImage& image) {
+		image.width = compressed.width;
+		image.height = compressed.height;
+		image.numLevels = compressed.numLevels;
+		image.format = GL_RGBA;
+		image.premultiplied = false;
+		image.pixels.resize(image.getLevelOffset(image.numLevels));
+
+		for (int level = 0; level < compressed.numLevels; level++) {
+			const unsigned char* block = &(compressed.pixels[compressed.getLevelOffset(level)]);
+			unsigned char* dest = &(image.pixels[image.getLevelOffset(level)]);
+			unsigned long width = image.getLevelWidth(level);
+			unsigned long height = image.getLevelHeight(level);
+
+			for (unsigned long by = 0; by < height; by += 4) {
+				for (unsigned long bx = 0; bx < width; bx += 4) {
+					unsigned char pixels[16 * 4];
+					switch (compressed.format) {
+						case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+							BlockDecompressor::decodeBC1(block, pixels, false);
+							block += 8;
+							break;
+						case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+							BlockDecompressor::decodeBC1(block, pixels, true);
+							block += 8;
+							break;
+						case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+							BlockDecompressor::decodeBC3(block, pixels);
+							block += 16;
+							break;
+						default:
+							BlockDecompressor::decodeBC7(block, pixels);
+							block += 16;
+							break;
+					}
+
+					//Blocks on the right and bottom edges can hang off the image, those pixels get thrown away.
+					for (unsigned long y = 0; y < 4 && by + y < height; y++) {
+						unsigned long numPixels = (width - bx < 4) ? width - bx : 4;
+						memcpy(dest + ((by + y) * width + bx) * 4, pixels + y * 16, numPixels * 4);
+					}
+				}
+			}
+		}
+	}
+
+	const char* CompressedImageLoader::getFormatName(GLenum format) {
+		switch (format) {
+			case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+			case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+				return "BC1";
+			case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+				return "BC3";
+			case GL_COMPRESSED_RGBA_BPTC_UNORM:
+				return "BC7";
+			default:
+				return "RGBA";
+		}
+	}
+
+	bool CompressedImageLoader::loadKTX(const unsigned char* data, uint64_t size, DecodedImage& image, std::string& error) {
+		if (size < sizeof(KTXHeader)) {
+			error = "KTX file is too small";
+			return false;
+		}
+		KTXHeader header;
+		memcpy(&header, data, sizeof(header));
+
+		if (header.endianness != 0x04030201) {
+			error = "KTX file is big endian";
+			return false;
+		}
+		if (header.glType != 0 || !isKnownFormat(header.glInternalFormat)) {
+			error = "KTX file isn't BC1, BC3 or BC7";
+			return false;
+		}
+		if (header.pixelDepth > 1 || header.numberOfArrayElements > 0 || header.numberOfFaces != 1) {
+			error = "Only 2D textures can be loaded from KTX files, not 3D, arrays or cube maps";
+			return false;
+		}
+
+		image.width = header.pixelWidth;
+		image.height = header.pixelHeight;
+		image.format = header.glInternalFormat;
+		image.premultiplied = false;
+		if (!checkSize(image, header.numberOfMipmapLevels, error)) {
+			return false;
+		}
+
+		uint64_t offset = sizeof(KTXHeader) + (uint64_t)header.bytesOfKeyValueData;
+		image.pixels.resize(image.getLevelOffset(image.numLevels));
+
+		//Each level is its size in bytes, then the blocks. The blocks are 8 or 16 bytes
+		//so they never need the padding KTX adds to get back to a multiple of 4.
+		for (int level = 0; level < image.numLevels; level++) {
+			uint32_t levelSize;
+			if (offset + 4 > size) {
+				error = "KTX file is cut off";
+				return false;
+			}
+			memcpy(&levelSize, data + offset, 4);
+			offset += 4;
+			if (levelSize != image.getLevelSize(level) || offset + levelSize > size) {
+				error = "KTX mipmap " + std::to_string(level) + " is the wrong size";
+				return false;
+			}
+			memcpy(&(image.pixels[image.getLevelOffset(level)]), data + offset, levelSize);
+			offset += levelSize;
+		}
+		return true;
+	}
+
+	bool CompressedImageLoader::loadDDS(const unsigned char* data, uint64_t size, DecodedImage& image, std::string& error) {
+		if (size < 4 + sizeof(DDSHeader)) {
+			error = "DDS file is too small";
+			return false;
+		}
+		DDSHeader header;
+		memcpy(&header, data + 4, sizeof(header));
+		uint64_t offset = 4 + sizeof(DDSHeader);
+
+		if (header.size != sizeof(DDSHeader) || (header.pfFlags & DDPF_FOURCC) == 0 || (header.caps2 & DDSCAPS2_CUBEMAP) != 0) {
+			error = "DDS file isn't a compressed 2D texture";
+			return false;
+		}
+
+		if (memcmp(header.pfFourCC, "DXT1", 4) == 0) {
+			image.format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+		} else if (memcmp(header.pfFourCC, "DXT5", 4) == 0) {
+			image.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		} else if (memcmp(header.pfFourCC, "DX10", 4) == 0) {
+			if (size < offset + sizeof(DDSHeaderDX10)) {
+				error = "DDS file is too small";
+				return false;
+			}
+			DDSHeaderDX10 dx10;
+			memcpy(&dx10, data + offset, sizeof(dx10));
+			offset += sizeof(dx10);
+
+			if (dx10.resourceDimension != DDS_DIMENSION_TEXTURE2D || dx10.arraySize > 1 || (dx10.miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE) != 0) {
+				error = "Only 2D textures can be loaded from DDS files, not 3D, arrays or cube maps";
+				return false;
+			}
+			//The _SRGB versions aren't here on purpose, nothing else in the engine does sRGB yet.
+			if (dx10.dxgiFormat == DXGI_FORMAT_BC1_UNORM) {
+				image.format = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+			} else if (dx10.dxgiFormat == DXGI_FORMAT_BC3_UNORM) {
+				image.format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			} else if (dx10.dxgiFormat == DXGI_FORMAT_BC7_UNORM) {
+				image.format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+			} else {
+				error = "DDS file isn't BC1, BC3 or BC7 (DXGI format " + std::to_string(dx10.dxgiFormat) + ")";
+				return false;
+			}
+		} else {
+			error = "DDS file isn't BC1, BC3 or BC7";
+			return false;
+		}
+
+		image.width = header.width;
+		image.height = header.height;
+		image.premultiplied = false;
+		if (!checkSize(image, (header.flags & DDSD_MIPMAPCOUNT) ? header.mipMapCount : 1, error)) {
+			return false;
+		}
+
+		//Unlike KTX, the levels are just one after the other with nothing in between.
+		size_t dataSize = image.getLevelOffset(image.numLevels);
+		if (size - offset < dataSize) {
+			error = "DDS file is cut off";
+			return false;
+		}
+		image.pixels.assign(data + offset, data + offset + dataSize);
+		return true;
+	}
+
+}
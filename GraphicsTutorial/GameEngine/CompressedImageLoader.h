@@ -0,0 +1,45 @@
+#pragma once
+
+#include "ImageLoader.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace GameEngine {
+
+	/*Reads textures that are already block compressed (see BlockDecompressor.h) out of .ktx and
+	.dds files. Those get uploaded exactly as they are, so a texture takes 4 or 8 times less video
+	memory than the same png, and there's nothing to decode when it loads.
+
+	Supported: BC1 (DXT1), BC3 (DXT5) and BC7 (BPTC), 2D only, with or without mipmaps.
+	Any image tool that exports .ktx (version 1) or .dds can make them.
+
+	If the driver doesn't have the extension for a format, decompress turns it into plain RGBA
+	on the loading thread instead, so the game still runs, it just doesn't save any memory.*/
+
+	class CompressedImageLoader
+	{
+	public:
+		//True for .ktx and .dds, ImageLoader uses this to decide which loader a path goes to.
+		static bool isCompressedFile(std::string_view filePath);
+
+		//Reads a .ktx or .dds that's already in memory. image gets the blocks for every mipmap in the
+		//file, with format set to the compressed format. Fills in error and returns false if we can't read it.
+		static bool load(const unsigned char* data, uint64_t size, DecodedImage& image, std::string& error);
+
+		//Whether openGL can take format as it is. glewInit has to have happened first, before that this is always false.
+		static bool isSupported(GLenum format);
+
+		//Decodes every level of compressed into plain RGBA.
+		static void decompress(const DecodedImage& compressed, DecodedImage& image);
+
+		//"BC1", "BC3", "BC7" or "RGBA", for printing.
+		static const char* getFormatName(GLenum format);
+
+	private:
+		static bool loadKTX(const unsigned char* data, uint64_t size, DecodedImage& image, std::string& error);
+		static bool loadDDS(const unsigned char* data, uint64_t size, DecodedImage& image, std::string& error);
+	};
+
+}
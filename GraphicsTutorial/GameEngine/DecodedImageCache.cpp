@@ -0,0 +1,158 @@
+#include "DecodedImageCache.h"
+#include "AssetArchive.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+namespace GameEngine {
+
+	std::string DecodedImageCache::_folderPath;
+
+	namespace {
+
+		const uint32_t CACHE_VERSION = 2;
+
+		const uint32_t FLAG_PREMULTIPLIED = 1;
+
+		//At the start of every cached file, followed by the png's path and then the pixels.
+		struct CachedImageHeader {
+			char magic[4]; //always "GTEX"
+			uint32_t version;
+			uint64_t pngHash;
+			uint64_t pngSize;
+			uint32_t width;
+			uint32_t height;
+			uint32_t numLevels;
+			uint32_t pathLength;
+			uint32_t flags;
+			uint32_t padding;
+		};
+
+		//Hashes 8 bytes at a time, it only has to notice when a png changes, and it's way faster than decoding it.
+		uint64_t hashBytes(const unsigned char* data, uint64_t size) {
+			uint64_t hash = 14695981039346656037ull ^ size;
+			uint64_t i = 0;
+			for (; i + 8 <= size; i += 8) {
+				uint64_t chunk;
+				memcpy(&chunk, data + i, 8);
+				hash = (hash ^ chunk) * 1099511628211ull;
+				hash ^= hash >> 29;
+			}
+			for (; i < size; i++) {
+				hash = (hash ^ data[i]) * 1099511628211ull;
+			}
+			return hash;
+		}
+
+	}
+
+	void DecodedImageCache::init(const std::string& folderPath) {
+		_folderPath = folderPath;
+		if (!_folderPath.empty()) {
+			std::error_code error;
+			std::filesystem::create_directories(_folderPath, error);
+		}
+	}
+
+	bool DecodedImageCache::load(const std::string& filePath, const unsigned char* png, uint64_t pngSize, DecodedImage& image) {
+		if (!isEnabled()) {
+			return false;
+		}
+
+		std::string cachePath = getCachePath(filePath);
+		std::error_code error;
+		if (!std::filesystem::exists(cachePath, error)) {
+			return false;
+		}
+
+		MappedFile file;
+		if (file.open(cachePath) == false || file.size() < sizeof(CachedImageHeader)) {
+			return false;
+		}
+
+		CachedImageHeader header;
+		memcpy(&header, file.data(), sizeof(header));
+		if (memcmp(header.magic, "GTEX", 4) != 0 || header.version != CACHE_VERSION || header.pngSize != pngSize || header.numLevels == 0) {
+			return false;
+		}
+
+		//Two paths could hash to the same file name, so make sure it's really ours.
+		const char* cachedPath = (const char*)file.data() + sizeof(header);
+		if (file.size() - sizeof(header) < header.pathLength || !AssetArchive::pathsMatch(filePath, std::string_view(cachedPath, header.pathLength))) {
+			return false;
+		}
+
+		//Hashing the png is the slowest part of this, so it goes after the cheap checks.
+		if (header.pngHash != hashBytes(png, pngSize)) {
+			return false;
+		}
+
+		image.width = header.width;
+		image.height = header.height;
+		image.numLevels = header.numLevels;
+		image.format = GL_RGBA;
+		image.premultiplied = (header.flags & FLAG_PREMULTIPLIED) != 0;
+		uint64_t pixelsStart = sizeof(header) + header.pathLength;
+		uint64_t pixelsSize = image.getLevelOffset(image.numLevels);
+		if (file.size() - pixelsStart != pixelsSize) {
+			return false;
+		}
+
+		image.pixels.assign(file.data() + pixelsStart, file.data() + pixelsStart + pixelsSize);
+		return true;
+	}
+
+	void DecodedImageCache::save(const std::string& filePath, const unsigned char* png, uint64_t pngSize, const DecodedImage& image) {
+		if (!isEnabled()) {
+			return;
+		}
+
+		CachedImageHeader header = {};
+		memcpy(header.magic, "GTEX", 4);
+		header.version = CACHE_VERSION;
+		header.pngHash = hashBytes(png, pngSize);
+		header.pngSize = pngSize;
+		header.width = image.width;
+		header.height = image.height;
+		header.numLevels = image.numLevels;
+		header.pathLength = filePath.size();
+		header.flags = image.premultiplied ? FLAG_PREMULTIPLIED : 0;
+
+		//Write to a temporary file and rename it when it's done, so a crash (or another thread
+		//loading the same png) never leaves a half written file where load would find it.
+		std::string cachePath = getCachePath(filePath);
+		std::string tempPath = cachePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary);
+			if (out.fail()) {
+				return;
+			}
+			out.write((const char*)&header, sizeof(header));
+			out.write(filePath.data(), filePath.size());
+			out.write((const char*)&(image.pixels[0]), image.getLevelOffset(image.numLevels));
+			if (out.fail()) {
+				out.close();
+				std::remove(tempPath.c_str());
+				return;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, cachePath, error);
+		if (error) {
+			std::remove(tempPath.c_str());
+		}
+	}
+
+	std::string DecodedImageCache::getCachePath(const std::string& filePath) {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.gtex", (unsigned long long)AssetArchive::hashPath(filePath));
+		return _folderPath + "/" + name;
+	}
+
+}
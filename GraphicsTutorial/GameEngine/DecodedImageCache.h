@@ -0,0 +1,44 @@
+#pragma once
+
+#include "ImageLoader.h"
+
+#include <cstdint>
+#include <string>
+
+namespace GameEngine {
+
+	/*Decoding a png (inflating it and undoing the filters) is most of the time it takes to load
+	a texture, and we do the exact same work every time the game starts. This saves the decoded
+	pixels to a folder the first time, and after that ImageLoader reads them straight back.
+
+	Each png gets its own file in the folder, named after a hash of its path. The file remembers
+	a hash and the size of the png it was made from, so if the png changes the old pixels are
+	just ignored and made again.
+
+	It also remembers whether the pixels were premultiplied and how many mipmaps it has, so
+	ImageLoader can tell if they were loaded with the same TextureOptions it wants now.
+
+	It's off until init is called. Call init before any loading starts, the loading threads
+	read the folder name without a lock.*/
+
+	class DecodedImageCache
+	{
+	public:
+		//Makes the folder if it isn't there. An empty folderPath turns the cache back off.
+		static void init(const std::string& folderPath);
+
+		//png and pngSize are the png file's bytes, so we can tell whether the cache is out of date.
+		//Returns false if it isn't cached (or the cache is off), then decode it like normal.
+		static bool load(const std::string& filePath, const unsigned char* png, uint64_t pngSize, DecodedImage& image);
+		//Nothing bad happens if this fails, the png just gets decoded again next time.
+		static void save(const std::string& filePath, const unsigned char* png, uint64_t pngSize, const DecodedImage& image);
+
+		static bool isEnabled() { return !_folderPath.empty(); }
+
+	private:
+		static std::string getCachePath(const std::string& filePath);
+
+		static std::string _folderPath;
+	};
+
+}
@@ -1,7 +1,8 @@
 #include "GLSLProgram.h"
 #include "Errors.h"
+#include "MappedFile.h"
 
-#include <fstream>
+#include <algorithm>
 #include <vector>
 
 namespace GameEngine {
@@ -47,31 +48,18 @@ namespace GameEngine {
 	void GLSLProgram::compileShader(const std::string& filePath, GLuint shaderId) {
 		//Now that a vertex shader and a fragment shader have been created,
 		//we need to load the code that we created in the shader files.
-		//The fstream variable is defined at the same time the file is opened. 
+		//The file gets mapped straight into memory, and openGL reads the source right out of it.
 
-		std::ifstream shaderFile(filePath);
-		if (shaderFile.fail()) {
-			perror(filePath.c_str());
+		MappedFile shaderFile;
+		if (shaderFile.open(filePath) == false) {
 			fatalError("Failed to open " + filePath);
 		}
 
-		//initializing variables.
-		std::string fileContents = "";
-		std::string line;
-
-		//getline does not include the carriage return
-		while (std::getline(shaderFile, line)) {
-			fileContents += line + "\n";
-		}
-
-		shaderFile.close();
-
-		//For some reason you can't just use &fileContents.c_str()
-		//So we just create a char* variable and store it, then put it in there
-		//For some reason that works. Since we only have on string in our c_str
-		//we can just use nullptr instead of an array containing the length of all strings.
-		const char* contentsPtr = fileContents.c_str();
-		glShaderSource(shaderId, 1, &contentsPtr, nullptr);
+		//The mapped file doesn't end with a null character like a c_str() does,
+		//so instead of nullptr we tell openGL how long it is.
+		const char* contentsPtr = (const char*)shaderFile.data();
+		GLint contentsLength = (GLint)shaderFile.size();
+		glShaderSource(shaderId, 1, &contentsPtr, &contentsLength);
 		glCompileShader(shaderId);
 
 		//Get Integer value of the CompileStatus, and throw it into success.
@@ -140,14 +128,92 @@ namespace GameEngine {
 		//Make sure you free up resources by releasing the memory.
 		glDeleteShader(_vertexShaderId);
 		glDeleteShader(_fragmentShaderId);
+
+		readActiveVariables();
+	}
+
+	void GLSLProgram::readActiveVariables() {
+		_uniforms.clear();
+		_attributes.clear();
+
+		//The longest name openGL could give us, including the null character.
+		GLint numUniforms = 0;
+		GLint maxUniformLength = 0;
+		glGetProgramiv(_programId, GL_ACTIVE_UNIFORMS, &numUniforms);
+		glGetProgramiv(_programId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxUniformLength);
+		GLint numAttributes = 0;
+		GLint maxAttributeLength = 0;
+		glGetProgramiv(_programId, GL_ACTIVE_ATTRIBUTES, &numAttributes);
+		glGetProgramiv(_programId, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxAttributeLength);
+
+		std::vector<char> name(std::max(std::max(maxUniformLength, maxAttributeLength), 1));
+
+		//Arrays come back as "lights[0]", but everyone asks for them as "lights".
+		auto makeVariable = [&name](GLsizei length, GLenum type, GLint size) {
+			ShaderVariable variable;
+			variable.name.assign(name.data(), length);
+			if (variable.name.size() > 3 && variable.name.compare(variable.name.size() - 3, 3, "[0]") == 0) {
+				variable.name.resize(variable.name.size() - 3);
+			}
+			variable.type = type;
+			variable.size = size;
+			return variable;
+		};
+
+		//The index openGL uses here isn't the location, those have to be asked for separately.
+		for (GLint i = 0; i < numUniforms; i++) {
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(_programId, i, (GLsizei)name.size(), &length, &size, &type, name.data());
+			ShaderVariable uniform = makeVariable(length, type, size);
+			uniform.location = glGetUniformLocation(_programId, name.data());
+			//Uniforms in a uniform block don't have a location, those get set through a buffer instead.
+			if (uniform.location != -1) {
+				_uniforms.push_back(uniform);
+			}
+		}
+
+		for (GLint i = 0; i < numAttributes; i++) {
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveAttrib(_programId, i, (GLsizei)name.size(), &length, &size, &type, name.data());
+			ShaderVariable attribute = makeVariable(length, type, size);
+			attribute.location = glGetAttribLocation(_programId, name.data());
+			_attributes.push_back(attribute);
+		}
 	}
 
-	GLuint GLSLProgram::getUniformLocation(const std::string& uniformName) {
-		GLint location = glGetUniformLocation(_programId, uniformName.c_str());
-		if (location == GL_INVALID_INDEX) {
+	UniformHandle GLSLProgram::findUniform(const std::string& uniformName) const {
+		for (UniformHandle handle = 0; handle < (UniformHandle)_uniforms.size(); handle++) {
+			if (_uniforms[handle].name == uniformName) {
+				return handle;
+			}
+		}
+		return -1;
+	}
+
+	UniformHandle GLSLProgram::getUniform(const std::string& uniformName) const {
+		UniformHandle handle = findUniform(uniformName);
+		if (handle == -1) {
 			fatalError("Uniform " + uniformName + " not found in shader!");
 		}
-		return location;
+		return handle;
+	}
+
+	GLint GLSLProgram::getUniformLocation(const std::string& uniformName) const {
+		return _uniforms[getUniform(uniformName)].location;
+	}
+
+	GLint GLSLProgram::getAttributeLocation(const std::string& attributeName) const {
+		for (const ShaderVariable& attribute : _attributes) {
+			if (attribute.name == attributeName) {
+				return attribute.location;
+			}
+		}
+		fatalError("Attribute " + attributeName + " not found in shader!");
+		return -1;
 	}
 
 
@@ -1,11 +1,28 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <GL\glew.h>
+#include <glm/glm.hpp>
 
 namespace GameEngine {
 
+	//Handed out by getUniform. It's the uniform's spot in the program's table, look it up once
+	//after linking and use it with setUniform every frame.
+	typedef int UniformHandle;
+
+	//One active uniform or attribute, as openGL describes it after linking.
+	struct ShaderVariable {
+		std::string name; //arrays have the [0] taken off the end
+		GLint location;
+		GLenum type; //GL_FLOAT_MAT4, GL_SAMPLER_2D...
+		GLint size; //how many elements, 1 unless it's an array
+	};
+
 	//Basically, our program that was written in two text files needs to be compiled
 	//into a program that OpenGL can use.
+	//
+	//After it links, we ask openGL for every active uniform and attribute once and keep them in a
+	//table, so setting a uniform every frame doesn't have to send a string through the driver.
 
 	class GLSLProgram
 	{
@@ -22,7 +39,26 @@ namespace GameEngine {
 		void addAttribute(const std::string& attributeName);
 
 		//To  use a uniform variable, we have to retrieve its id or its location.
-		GLuint getUniformLocation(const std::string& uniformName);
+		//This comes out of the table now, it doesn't ask openGL.
+		GLint getUniformLocation(const std::string& uniformName) const;
+		GLint getAttributeLocation(const std::string& attributeName) const;
+
+		//Finds the uniform in the table, do it once after linkShaders and keep the handle.
+		//The shader compiler throws away uniforms that aren't used, asking for one of those is a fatal error.
+		UniformHandle getUniform(const std::string& uniformName) const;
+		//-1 if there's no uniform called that, for ones that are allowed to be missing.
+		UniformHandle findUniform(const std::string& uniformName) const;
+		const ShaderVariable& getUniformInfo(UniformHandle handle) const { return _uniforms[handle]; }
+		const std::vector<ShaderVariable>& getUniforms() const { return _uniforms; }
+		const std::vector<ShaderVariable>& getAttributes() const { return _attributes; }
+
+		//These only work while the program is in use (between use and unuse).
+		void setUniform(UniformHandle handle, int value) { glUniform1i(_uniforms[handle].location, value); }
+		void setUniform(UniformHandle handle, float value) { glUniform1f(_uniforms[handle].location, value); }
+		void setUniform(UniformHandle handle, const glm::vec2& value) { glUniform2fv(_uniforms[handle].location, 1, &(value[0])); }
+		void setUniform(UniformHandle handle, const glm::vec3& value) { glUniform3fv(_uniforms[handle].location, 1, &(value[0])); }
+		void setUniform(UniformHandle handle, const glm::vec4& value) { glUniform4fv(_uniforms[handle].location, 1, &(value[0])); }
+		void setUniform(UniformHandle handle, const glm::mat4& value) { glUniformMatrix4fv(_uniforms[handle].location, 1, GL_FALSE, &(value[0][0])); }
 
 		//Apparently we have to tell openGL to use our programs that we create.
 		//This is where that happens. This will appear in the drawGame function in MainGame.cpp
@@ -40,7 +76,13 @@ namespace GameEngine {
 
 		GLuint _vertexShaderId;
 		GLuint _fragmentShaderId;
+
+		//Filled in by linkShaders. There's only ever a handful, so looking a name up is just a loop.
+		std::vector<ShaderVariable> _uniforms;
+		std::vector<ShaderVariable> _attributes;
+
 		void compileShader(const std::string& filePath, GLuint shaderId);
+		void readActiveVariables();
 	};
 
 }
@@ -9,6 +9,8 @@ namespace GameEngine {
 		GLuint id;
 		int width;
 		int height;
+		//About how much video memory it takes, mipmaps included. Compressed textures are a lot smaller.
+		size_t memorySize;
 	};
 
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #include "IOManger.h"
+#include "AssetArchive.h"
+
 #include <fstream>
 
 namespace GameEngine {
+	std::vector<std::unique_ptr<AssetArchive>> IOManger::_archives;
 
 	bool IOManger::readFileToBuffer(std::string filePath, std::vector<unsigned char>& buffer) {
 		//We are reading this to get a byte stream, most likely this is for images.
@@ -14,8 +17,8 @@ namespace GameEngine {
 		//seek to the end, 0 bytes from the end (0, std::ios::end)
 		myFile.seekg(0, std::ios::end);
 
-		//Get the file size
-		int fileSize = myFile.tellg();
+		//Get the file size. std::streamoff is 64 bits, an int would go negative on files over 2GB.
+		std::streamoff fileSize = myFile.tellg();
 
 		//seek to the beginning, 0 bytes from the beginning.
 		myFile.seekg(0, std::ios::beg);
@@ -23,7 +26,14 @@ namespace GameEngine {
 		//Reduce the file size by any header byes that might be present
 		fileSize -= myFile.tellg();
 
-		buffer.resize(fileSize);
+		if (fileSize < 0 || (unsigned long long)fileSize > buffer.max_size()) {
+			perror(filePath.c_str());
+			return false;
+		}
+		buffer.resize((size_t)fileSize);
+		if (fileSize == 0) {
+			return true;
+		}
 
 		//A vector is basically a wrapper around an array, so if we 
 		//reference the first element in the vector and point to that
@@ -34,9 +44,54 @@ namespace GameEngine {
 		//the buffer variable, it will be of type unsigned char because we are 
 		//reading binary data. So we have to convert this to a char*
 		myFile.read((char *)&(buffer[0]), fileSize);
+		if (myFile.fail()) {
+			perror(filePath.c_str());
+			return false;
+		}
 		myFile.close();
 
 		return true;
 	}
 
-}
+	bool IOManger::mountArchive(const std::string& archivePath) {
+		std::unique_ptr<AssetArchive> archive = std::make_unique<AssetArchive>();
+		if (archive->open(archivePath) == false) {
+			return false;
+		}
+		_archives.push_back(std::move(archive));
+		return true;
+	}
+
+	void IOManger::unmountArchives() {
+		_archives.clear();
+	}
+
+	bool IOManger::findInArchives(std::string_view filePath, const unsigned char*& data, uint64_t& size) {
+		//The last one mounted wins, so a patch archive can replace files from the main one.
+		for (auto it = _archives.rbegin(); it != _archives.rend(); it++) {
+			if ((*it)->find(filePath, data, size)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::vector<std::string> IOManger::getArchivedFiles(std::string_view folderPath) {
+		while (!folderPath.empty() && (folderPath.back() == '/' || folderPath.back() == '\\')) {
+			folderPath.remove_suffix(1);
+		}
+
+		std::vector<std::string> files;
+		for (auto& archive : _archives) {
+			for (int i = 0; i < archive->getNumSlots(); i++) {
+				std::string_view path = archive->getPath(i);
+				if (path.size() > folderPath.size() && (path[folderPath.size()] == '/' || path[folderPath.size()] == '\\') &&
+					AssetArchive::pathsMatch(path.substr(0, folderPath.size()), folderPath)) {
+					files.emplace_back(path);
+				}
+			}
+		}
+		return files;
+	}
+
+}
\ No newline at end of file
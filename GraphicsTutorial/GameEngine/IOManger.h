@@ -1,17 +1,35 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <vector>
 #include <string>
+#include <string_view>
 
 namespace GameEngine {
 
+	class AssetArchive;
+
 	class IOManger
 	{
 	public:
 		//So that we can return a boolean variable and fill the
 		//provided by reference vector with the file contents.
 		//Because we are reading binary data, unsigned char is more fitting.
+		//If you only need to read the file, MappedFile is faster, it doesn't copy anything.
 		static bool readFileToBuffer(std::string filePath, std::vector<unsigned char>& buffer);
+
+		//After this, MappedFile::open looks for files inside the archive before it looks on the disk.
+		//Mount everything before any loading starts, the texture loading threads read the list without a lock.
+		static bool mountArchive(const std::string& archivePath);
+		static void unmountArchives();
+		static bool findInArchives(std::string_view filePath, const unsigned char*& data, uint64_t& size);
+		//Every archived path that starts with folderPath/, for when the folder isn't on the disk.
+		static std::vector<std::string> getArchivedFiles(std::string_view folderPath);
+
+	private:
+		//unique_ptr so the archives never move, MappedFiles are pointing into them.
+		static std::vector<std::unique_ptr<AssetArchive>> _archives;
 	};
 
 }
\ No newline at end of file
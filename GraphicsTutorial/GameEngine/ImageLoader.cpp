@@ -1,6 +1,9 @@
 #include "ImageLoader.h"
 #include "picoPNG.h"
-#include "IOManger.h"
+#include "MappedFile.h"
+#include "DecodedImageCache.h"
+#include "MipmapBuilder.h"
+#include "CompressedImageLoader.h"
 #include "Errors.h"
 
 namespace GameEngine {
@@ -12,27 +15,113 @@ namespace GameEngine {
 	4:  copy some image we want on the texture to the GL_TEXTURE target.
 	*/
 
-	GLTexture ImageLoader::loadPNG(std::string filePath) {
-		GLTexture texture = {};
+	GLTexture ImageLoader::loadPNG(std::string filePath, const TextureOptions& options) {
+		DecodedImage image;
+		std::string error;
+		if (decodePNG(filePath, image, error, options) == false) {
+			fatalError(error);
+		}
+		return uploadTexture(image, options);
+	}
+
+	GLTexture ImageLoader::loadTexture(std::string filePath, const TextureOptions& options) {
+		DecodedImage image;
+		std::string error;
+		if (decodeImage(filePath, image, error, options) == false) {
+			fatalError(error);
+		}
+		return uploadTexture(image, options);
+	}
+
+	bool ImageLoader::decodeImage(const std::string& filePath, DecodedImage& image, std::string& error, const TextureOptions& options) {
+		if (CompressedImageLoader::isCompressedFile(filePath)) {
+			return decodeCompressed(filePath, image, error, options);
+		}
+		return decodePNG(filePath, image, error, options);
+	}
 
-		//input data - from image retrieved by IOManger::readFileToBuffer
-		std::vector<unsigned char> in;
-		std::vector<unsigned char> out;
+	bool ImageLoader::decodePNG(const std::string& filePath, DecodedImage& image, std::string& error, const TextureOptions& options) {
+		//input data - the png file mapped straight into memory, picoPNG reads it right from there.
+		MappedFile in;
 
-		//can initialize two vars on same line
-		unsigned long width, height;
+		if (in.open(filePath) == false) {
+			error = "Failed to load PNG file to buffer!";
+			return false;
+		}
 
-		if (IOManger::readFileToBuffer(filePath, in) == false) {
-			fatalError("Failed to load PNG file to buffer!");
+		//If we decoded this exact png last time, the pixels are already sitting on the disk.
+		//It has to have been loaded the same way though, or the pixels won't be the same.
+		if (DecodedImageCache::load(filePath, in.data(), in.size(), image) &&
+			image.premultiplied == options.premultiplyAlpha &&
+			(image.numLevels > 1) == (options.mipmaps == MipmapMode::CPU)) {
+			return true;
 		}
 
-		int errorCode = decodePNG(out, width, height, &(in[0]), in.size());
+		int errorCode = GameEngine::decodePNG(image.pixels, image.width, image.height, in.data(), (size_t)in.size());
 		if (errorCode != 0) {
 			//std::to_string to convert something to string, it would still be converted
 			//because c++ knows an int can be a string, but that's how to make sure.
-			fatalError("decodePNG failed with error: " + std::to_string(errorCode));
+			error = "decodePNG failed with error: " + std::to_string(errorCode);
+			return false;
+		}
+		//So now our pixels vector has been filled with the decoded data, becauser we sent it by reference.
+		image.numLevels = 1;
+		image.format = GL_RGBA;
+		image.premultiplied = false;
+
+		//Premultiplying has to come first, the mipmaps should average the premultiplied colors.
+		if (options.premultiplyAlpha) {
+			premultiplyAlpha(image);
+		}
+		if (options.mipmaps == MipmapMode::CPU) {
+			MipmapBuilder::buildMipmaps(image);
+		}
+
+		DecodedImageCache::save(filePath, in.data(), in.size(), image);
+		return true;
+	}
+
+	bool ImageLoader::decodeCompressed(const std::string& filePath, DecodedImage& image, std::string& error, const TextureOptions& options) {
+		MappedFile in;
+		if (in.open(filePath) == false) {
+			error = "Failed to load compressed texture file to buffer!";
+			return false;
+		}
+
+		DecodedImage compressed;
+		if (CompressedImageLoader::load(in.data(), in.size(), compressed, error) == false) {
+			return false;
 		}
-		//So now our in vector has been filled with the decoded data, becauser we sent it by reference.
+
+		//The normal case, the gpu takes the blocks just the way they are.
+		if (CompressedImageLoader::isSupported(compressed.format)) {
+			image = std::move(compressed);
+			return true;
+		}
+
+		//Without the extension we have to decode it ourselves. Mipmaps in the file are always kept,
+		//otherwise we only have them if options asked for cpu mipmaps.
+		bool wantsMipmaps = compressed.numLevels > 1 || options.mipmaps == MipmapMode::CPU;
+		if (DecodedImageCache::load(filePath, in.data(), in.size(), image) &&
+			image.premultiplied == options.premultiplyAlpha &&
+			(image.numLevels > 1) == wantsMipmaps) {
+			return true;
+		}
+
+		CompressedImageLoader::decompress(compressed, image);
+		if (options.premultiplyAlpha) {
+			premultiplyAlpha(image);
+		}
+		if (options.mipmaps == MipmapMode::CPU && image.numLevels == 1) {
+			MipmapBuilder::buildMipmaps(image);
+		}
+
+		DecodedImageCache::save(filePath, in.data(), in.size(), image);
+		return true;
+	}
+
+	GLTexture ImageLoader::uploadTexture(const DecodedImage& image, const TextureOptions& options) {
+		GLTexture texture = {};
 
 		//Now we are generating a texture. Generating 1 texture, and give it our GLTexture.id by reference.
 		glGenTextures(1, &(texture.id));
@@ -42,32 +131,73 @@ namespace GameEngine {
 
 		//Upload the image to the openGL texture.
 		//unsigned char is an unsigned byte, which is the type of data we are feeding it.
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, &(out[0]));
+		//If the mipmaps were made already, each one goes into its own level.
+		for (int level = 0; level < image.numLevels; level++) {
+			if (image.isCompressed()) {
+				//Compressed blocks go in as they are, openGL just needs to know how many bytes there are.
+				glCompressedTexImage2D(GL_TEXTURE_2D, level, image.format, image.getLevelWidth(level), image.getLevelHeight(level), 0,
+					(GLsizei)image.getLevelSize(level), &(image.pixels[image.getLevelOffset(level)]));
+			} else {
+				glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA, image.getLevelWidth(level), image.getLevelHeight(level), 0, GL_RGBA, GL_UNSIGNED_BYTE, &(image.pixels[image.getLevelOffset(level)]));
+			}
+		}
+		//How many levels the texture ends up with, for working out how much memory it takes.
+		int numLevels = image.numLevels;
 
 		//I think we are telling openGL how we want our image to be rendered, hence parameters.
 		//GL_TEXTURE_WRAP - Is at texture wrapping parameter. How do we want the texture to wrap on one image.
 		//example: if a texture extends beyond the given coordinates, do we repeat the image? cut off the rest of the image? etc.
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		GLint wrap = options.wrap == TextureWrap::REPEAT ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
 
 		//MipMaping, based on size of texture, in this case linear interpolation. 
 		//A bad setting/paramter would be to use the next pixel in the case of mipmaping, making the texture look awful, instead of averaging.
 		//Two settings, magnifying and minimizing. Too big vs too small, and what to do in either case.
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
+		bool nearest = options.filter == TextureFilter::NEAREST;
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, nearest ? GL_NEAREST : GL_LINEAR);
 
 		//Mipmaping is basically averaging pixels when an image is rendered smaller than it's native resolution.
 		//If mipmaping isn't on then the image looks weird and gross.
-		glGenerateMipmap(GL_TEXTURE_2D);
+		//glGenerateMipmap can't make mipmaps for a compressed texture, so without any in the file it doesn't get them.
+		if ((options.mipmaps == MipmapMode::NONE || image.isCompressed()) && image.numLevels == 1) {
+			//Without this openGL would wait for mipmaps that are never coming, and draw nothing.
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, nearest ? GL_NEAREST : GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+		} else {
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, nearest ? GL_NEAREST_MIPMAP_NEAREST : GL_LINEAR_MIPMAP_LINEAR);
+			if (image.numLevels > 1) {
+				//The chain might stop before 1x1, so tell openGL which level is the last one we have.
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.numLevels - 1);
+			} else {
+				glGenerateMipmap(GL_TEXTURE_2D);
+				numLevels = MipmapBuilder::getNumLevels(image.width, image.height);
+			}
+		}
 
 		//Now we release the texture, even though it would probably be released anyhow because of the stack.
 		glBindTexture(GL_TEXTURE_2D, 0);
 
-		texture.width = width;
-		texture.height = height;
+		texture.width = image.width;
+		texture.height = image.height;
+		//The mipmaps openGL made are the same size as the ones we would have made, so this counts them too.
+		texture.memorySize = image.getLevelOffset(numLevels);
 
 		return texture;
 	}
 
+	void ImageLoader::premultiplyAlpha(DecodedImage& image) {
+		unsigned char* pixel = image.pixels.data();
+		unsigned char* end = pixel + image.getLevelOffset(image.numLevels);
+		for (; pixel < end; pixel += 4) {
+			unsigned int alpha = pixel[3];
+			for (int c = 0; c < 3; c++) {
+				//(x + 128 + ((x + 128) >> 8)) >> 8 is x / 255 rounded to nearest, without dividing.
+				unsigned int x = pixel[c] * alpha + 128;
+				pixel[c] = (unsigned char)((x + (x >> 8)) >> 8);
+			}
+		}
+		image.premultiplied = true;
+	}
+
 }
\ No newline at end of file
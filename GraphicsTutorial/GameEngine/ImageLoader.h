@@ -2,14 +2,96 @@
 
 #include "GLTexture.h"
 
+#include <algorithm>
 #include <string>
+#include <vector>
 
 namespace GameEngine {
 
+	//Pixels that have been decoded but haven't been sent to openGL yet.
+	struct DecodedImage {
+		std::vector<unsigned char> pixels; //RGBA, 4 bytes per pixel, unless format says it's compressed
+		unsigned long width;
+		unsigned long height;
+		//GL_RGBA, or one of the block compressed formats from CompressedImageLoader.
+		GLenum format = GL_RGBA;
+		bool premultiplied = false;
+		//If this is more than 1, pixels has the mipmaps too, one after the other, each half the size
+		//of the one before it (but never smaller than 1 pixel), and openGL doesn't have to make them.
+		int numLevels = 1;
+
+		bool isCompressed() const { return format != GL_RGBA; }
+		unsigned long getLevelWidth(int level) const { return std::max(width >> level, 1ul); }
+		unsigned long getLevelHeight(int level) const { return std::max(height >> level, 1ul); }
+		//How many bytes level takes up.
+		size_t getLevelSize(int level) const {
+			if (!isCompressed()) {
+				return getLevelWidth(level) * getLevelHeight(level) * 4;
+			}
+			//Compressed formats are made of 4x4 blocks, so a 1x1 mipmap still takes a whole block.
+			size_t numBlocks = ((getLevelWidth(level) + 3) / 4) * ((getLevelHeight(level) + 3) / 4);
+			bool bc1 = format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+			return numBlocks * (bc1 ? 8 : 16);
+		}
+		//Where level starts in pixels, in bytes.
+		size_t getLevelOffset(int level) const {
+			size_t offset = 0;
+			for (int i = 0; i < level; i++) {
+				offset += getLevelSize(i);
+			}
+			return offset;
+		}
+	};
+
+	enum class MipmapMode {
+		NONE, //for things that are never drawn smaller than they are, like UI. Saves a third of the memory.
+		GPU, //glGenerateMipmap on the main thread when it's uploaded
+		CPU //MipmapBuilder makes them on the loading thread, and they get uploaded with the image
+	};
+
+	enum class TextureFilter {
+		NEAREST, //blocky, good for pixel art
+		LINEAR //smooth
+	};
+
+	enum class TextureWrap {
+		REPEAT, //uvs past 1 start the image over
+		CLAMP //uvs past 1 keep using the edge pixels, so nothing bleeds in from the other side
+	};
+
+	//How a texture gets loaded. The defaults are what every texture used to get.
+	struct TextureOptions {
+		MipmapMode mipmaps = MipmapMode::GPU;
+		TextureFilter filter = TextureFilter::LINEAR;
+		TextureWrap wrap = TextureWrap::REPEAT;
+		//Multiplies the color by the alpha when it's loaded, for drawing with glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA).
+		//Compressed textures can't be changed without decoding them, so premultiply those before compressing them.
+		bool premultiplyAlpha = false;
+	};
+
 	class ImageLoader
 	{
 	public:
-		static GLTexture loadPNG(std::string filePath);
+		//Reads and decodes in one go on the calling thread, then uploads.
+		static GLTexture loadPNG(std::string filePath, const TextureOptions& options = TextureOptions());
+		//Same thing, but .ktx and .dds files go through CompressedImageLoader and everything else is a png.
+		//This is the one TextureCache uses, so which kind of file you give it picks how it's stored.
+		static GLTexture loadTexture(std::string filePath, const TextureOptions& options = TextureOptions());
+		static bool decodeImage(const std::string& filePath, DecodedImage& image, std::string& error, const TextureOptions& options = TextureOptions());
+
+		//Loading is split in two so the slow half can happen on another thread.
+		//decodePNG doesn't touch openGL so it's safe on any thread. It returns false and fills in
+		//error instead of calling fatalError, because fatalError has to be called from the main thread.
+		//It also does the parts of options that change the pixels (premultiplying and cpu mipmaps).
+		static bool decodePNG(const std::string& filePath, DecodedImage& image, std::string& error, const TextureOptions& options = TextureOptions());
+		//Keeps the blocks as they are if the driver supports them. If it doesn't they're decoded to RGBA here,
+		//and since that's slow (BC7 especially) the result goes in the DecodedImageCache just like a png.
+		static bool decodeCompressed(const std::string& filePath, DecodedImage& image, std::string& error, const TextureOptions& options = TextureOptions());
+		//This one needs openGL, so only call it from the thread that made the window.
+		static GLTexture uploadTexture(const DecodedImage& image, const TextureOptions& options = TextureOptions());
+
+		//Every color channel times alpha / 255, rounded to nearest.
+		static void premultiplyAlpha(DecodedImage& image);
 	};
 
 }
@@ -0,0 +1,196 @@
+#include "MappedFile.h"
+#include "IOManger.h"
+
+#include <cstdio>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace GameEngine {
+
+	//Setting up a mapping costs more than just reading a small file, so anything smaller than
+	//this gets read into the buffer instead (most of our pngs are only a few kilobytes).
+	const uint64_t MIN_MAPPED_SIZE = 64 * 1024;
+
+	MappedFile::MappedFile() :
+		_data(nullptr),
+		_size(0),
+		_isOpen(false),
+		_mapping(nullptr),
+		_fileHandle(nullptr),
+		_mappingHandle(nullptr)
+	{
+	}
+
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept : MappedFile() {
+		moveFrom(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			close();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	bool MappedFile::open(const std::string& filePath) {
+		close();
+
+		//Files in a mounted archive are already mapped, we just point at them.
+		if (IOManger::findInArchives(filePath, _data, _size)) {
+			_isOpen = true;
+			return true;
+		}
+
+		if (openFile(filePath) == false) {
+			//Some files can't be opened this way (pipes, some network drives), so just read it the old way.
+			if (IOManger::readFileToBuffer(filePath, _fallback) == false) {
+				return false;
+			}
+			_data = _fallback.empty() ? nullptr : &(_fallback[0]);
+			_size = _fallback.size();
+		}
+
+		_isOpen = true;
+		return true;
+	}
+
+	void MappedFile::close() {
+#if defined(_WIN32)
+		if (_mapping != nullptr) UnmapViewOfFile(_mapping);
+		if (_mappingHandle != nullptr) CloseHandle(_mappingHandle);
+		if (_fileHandle != nullptr) CloseHandle(_fileHandle);
+#else
+		if (_mapping != nullptr) munmap(_mapping, _size);
+#endif
+		_mapping = nullptr;
+		_mappingHandle = nullptr;
+		_fileHandle = nullptr;
+
+		//swap with an empty vector actually gives the memory back, clear() would hang on to it.
+		std::vector<unsigned char>().swap(_fallback);
+
+		_data = nullptr;
+		_size = 0;
+		_isOpen = false;
+	}
+
+	bool MappedFile::openFile(const std::string& filePath) {
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (GetFileSizeEx(file, &fileSize) == FALSE) {
+			CloseHandle(file);
+			return false;
+		}
+
+		if ((uint64_t)fileSize.QuadPart < MIN_MAPPED_SIZE) {
+			//Small (or empty, which can't be mapped at all), one ReadFile and we're done.
+			_fallback.resize((size_t)fileSize.QuadPart);
+			DWORD bytesRead = 0;
+			bool success = _fallback.empty() || (ReadFile(file, &(_fallback[0]), (DWORD)_fallback.size(), &bytesRead, nullptr) && bytesRead == _fallback.size());
+			CloseHandle(file);
+			if (!success) {
+				return false;
+			}
+			_data = _fallback.empty() ? nullptr : &(_fallback[0]);
+			_size = _fallback.size();
+			return true;
+		}
+
+		HANDLE mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mappingHandle == nullptr) {
+			CloseHandle(file);
+			return false;
+		}
+
+		void* mapping = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		if (mapping == nullptr) {
+			CloseHandle(mappingHandle);
+			CloseHandle(file);
+			return false;
+		}
+
+		_fileHandle = file;
+		_mappingHandle = mappingHandle;
+		_mapping = mapping;
+		_size = fileSize.QuadPart;
+#else
+		int file = ::open(filePath.c_str(), O_RDONLY);
+		if (file == -1) {
+			return false;
+		}
+
+		struct stat info;
+		if (fstat(file, &info) != 0 || !S_ISREG(info.st_mode)) {
+			::close(file);
+			return false;
+		}
+
+		if ((uint64_t)info.st_size < MIN_MAPPED_SIZE) {
+			//Small (or empty, which can't be mapped at all), one read and we're done.
+			_fallback.resize((size_t)info.st_size);
+			bool success = _fallback.empty() || ::read(file, &(_fallback[0]), _fallback.size()) == (ssize_t)_fallback.size();
+			::close(file);
+			if (!success) {
+				return false;
+			}
+			_data = _fallback.empty() ? nullptr : &(_fallback[0]);
+			_size = _fallback.size();
+			return true;
+		}
+
+		void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		//Once it's mapped the file can be closed, the mapping keeps its own reference.
+		::close(file);
+		if (mapping == MAP_FAILED) {
+			return false;
+		}
+		//We read images front to back, so let the OS read ahead.
+		madvise(mapping, info.st_size, MADV_SEQUENTIAL);
+
+		_mapping = mapping;
+		_size = info.st_size;
+#endif
+		_data = (const unsigned char*)_mapping;
+		return true;
+	}
+
+	void MappedFile::moveFrom(MappedFile& other) {
+		//A vector keeps its memory when it's moved, so _data is still good whichever way it was opened.
+		_fallback = std::move(other._fallback);
+		_data = other._data;
+		_size = other._size;
+		_isOpen = other._isOpen;
+		_mapping = other._mapping;
+		_fileHandle = other._fileHandle;
+		_mappingHandle = other._mappingHandle;
+
+		other._data = nullptr;
+		other._size = 0;
+		other._isOpen = false;
+		other._mapping = nullptr;
+		other._fileHandle = nullptr;
+		other._mappingHandle = nullptr;
+	}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace GameEngine {
+
+	/*A read only look at all the bytes of a file, without copying them into a vector first.
+	The operating system maps the file straight into our memory (mmap on linux/mac,
+	MapViewOfFile on windows), and only reads each page off the disk when we first touch it.
+	Small files are cheaper to just read, so those go into a buffer it keeps inside with a
+	single read call, and so does anything that can't be mapped. Whoever is using it doesn't
+	have to care which one happened. If the file is inside of an archive mounted with
+	IOManger::mountArchive, it just points at it there.
+
+	The data is only good while the MappedFile is still open, so don't keep pointers into it around.*/
+
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		//Can't copy it (two of them would both try to unmap the same memory), but it can be moved.
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		//Closes whatever was open before. Prints why and returns false if the file can't be opened.
+		bool open(const std::string& filePath);
+		void close();
+
+		//data can be nullptr if the file is empty, so check size first.
+		const unsigned char* data() const { return _data; }
+		uint64_t size() const { return _size; }
+		bool isOpen() const { return _isOpen; }
+		//True if this file has its own mapping (not a small file, and not in an archive).
+		bool isMapped() const { return _mapping != nullptr; }
+
+	private:
+		//Maps big files and reads small ones. False means use IOManger::readFileToBuffer instead.
+		bool openFile(const std::string& filePath);
+		void moveFrom(MappedFile& other);
+
+		const unsigned char* _data;
+		uint64_t _size;
+		bool _isOpen;
+
+		//The start of the mapped memory, and on windows the handles that go with it.
+		void* _mapping;
+		void* _fileHandle;
+		void* _mappingHandle;
+
+		std::vector<unsigned char> _fallback;
+	};
+
+}
@@ -0,0 +1,96 @@
+#include "MipmapBuilder.h"
+
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define MIPMAP_BUILDER_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace GameEngine {
+
+	namespace {
+
+		const unsigned long BYTES_PER_PIXEL = 4;
+
+		//Averages the 2x2 block starting at column srcX for output pixels x to endX.
+		//If the image is only 1 pixel wide, the pixel to the right is the same pixel.
+		void downsampleRowScalar(const unsigned char* row0, const unsigned char* row1, unsigned long srcWidth, unsigned char* dest, unsigned long x, unsigned long endX) {
+			for (; x < endX; x++) {
+				unsigned long left = 2 * x * BYTES_PER_PIXEL;
+				unsigned long right = (2 * x + 1 < srcWidth ? 2 * x + 1 : 2 * x) * BYTES_PER_PIXEL;
+				for (unsigned long c = 0; c < BYTES_PER_PIXEL; c++) {
+					dest[x * BYTES_PER_PIXEL + c] = (unsigned char)((row0[left + c] + row0[right + c] + row1[left + c] + row1[right + c] + 2) >> 2);
+				}
+			}
+		}
+
+#if defined(MIPMAP_BUILDER_SSE2)
+
+		//4 pixels from each row in, 2 pixels out.
+		void downsampleRowSSE2(const unsigned char* row0, const unsigned char* row1, unsigned long srcWidth, unsigned char* dest, unsigned long destWidth) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i two = _mm_set1_epi16(2);
+			unsigned long x = 0;
+			for (; x + 2 <= destWidth; x += 2) {
+				__m128i a = _mm_loadu_si128((const __m128i*)(row0 + 2 * x * BYTES_PER_PIXEL));
+				__m128i b = _mm_loadu_si128((const __m128i*)(row1 + 2 * x * BYTES_PER_PIXEL));
+
+				//Widen to 16 bits so the sums don't overflow, and add the two rows together.
+				//lo has source pixels 0 and 1, hi has source pixels 2 and 3.
+				__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+				__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+
+				//Add each pixel to its neighbour, the answer ends up in the low 4 channels of each.
+				lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+				hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+				__m128i sum = _mm_unpacklo_epi64(lo, hi);
+
+				__m128i average = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+				_mm_storel_epi64((__m128i*)(dest + x * BYTES_PER_PIXEL), _mm_packus_epi16(average, average));
+			}
+			downsampleRowScalar(row0, row1, srcWidth, dest, x, destWidth);
+		}
+
+#endif
+
+	}
+
+	void MipmapBuilder::buildMipmaps(DecodedImage& image) {
+		image.numLevels = getNumLevels(image.width, image.height);
+		image.pixels.resize(image.getLevelOffset(image.numLevels));
+
+		for (int level = 1; level < image.numLevels; level++) {
+			const unsigned char* src = &(image.pixels[image.getLevelOffset(level - 1)]);
+			unsigned char* dest = &(image.pixels[image.getLevelOffset(level)]);
+			downsample(src, image.getLevelWidth(level - 1), image.getLevelHeight(level - 1), dest);
+		}
+	}
+
+	void MipmapBuilder::downsample(const unsigned char* src, unsigned long srcWidth, unsigned long srcHeight, unsigned char* dest) {
+		unsigned long destWidth = srcWidth / 2 > 0 ? srcWidth / 2 : 1;
+		unsigned long destHeight = srcHeight / 2 > 0 ? srcHeight / 2 : 1;
+		unsigned long srcPitch = srcWidth * BYTES_PER_PIXEL;
+
+		for (unsigned long y = 0; y < destHeight; y++) {
+			const unsigned char* row0 = src + 2 * y * srcPitch;
+			//Same as the columns, a 1 pixel tall image uses its only row twice.
+			const unsigned char* row1 = 2 * y + 1 < srcHeight ? row0 + srcPitch : row0;
+			unsigned char* destRow = dest + y * destWidth * BYTES_PER_PIXEL;
+#if defined(MIPMAP_BUILDER_SSE2)
+			downsampleRowSSE2(row0, row1, srcWidth, destRow, destWidth);
+#else
+			downsampleRowScalar(row0, row1, srcWidth, destRow, 0, destWidth);
+#endif
+		}
+	}
+
+	int MipmapBuilder::getNumLevels(unsigned long width, unsigned long height) {
+		unsigned long size = width > height ? width : height;
+		int numLevels = 1;
+		while (size > 1) {
+			size /= 2;
+			numLevels++;
+		}
+		return numLevels;
+	}
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "ImageLoader.h"
+
+namespace GameEngine {
+
+	/*Makes the mipmaps for a DecodedImage on the cpu, so it can happen on a loading thread
+	instead of glGenerateMipmap doing it on the main thread while we're trying to draw.
+	Each level is a box filter of the one before it: every pixel is the average of the
+	2x2 block of pixels it came from (rounded to nearest). Odd sizes drop the last row or
+	column, the same way openGL works out the size of each level.
+
+	Rows are done 2 pixels at a time with SSE2 when we have it, and one pixel at a time
+	otherwise. Both give exactly the same result.*/
+
+	class MipmapBuilder
+	{
+	public:
+		//image has to only have level 0 in it. Afterwards it has every level down to 1x1.
+		static void buildMipmaps(DecodedImage& image);
+
+		//Makes one level out of the one above it. dest has to have room for (srcWidth/2) * (srcHeight/2) pixels
+		//(at least 1 each way).
+		static void downsample(const unsigned char* src, unsigned long srcWidth, unsigned long srcHeight, unsigned char* dest);
+
+		//How many levels it takes to get down to 1x1.
+		static int getNumLevels(unsigned long width, unsigned long height);
+	};
+
+}
@@ -0,0 +1,283 @@
+#include "PNGUnfilter.h"
+
+#include <cstring>
+
+//SSE2 is always there on x64, and on 32 bit x86 when the compiler is allowed to use it (the default since VS2012).
+//AVX2 only gets used if the CPU we're running on has it, so the functions that use it are compiled for it on their own.
+#if defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define PNG_UNFILTER_SSE2
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PNG_UNFILTER_AVX2_FUNCTION
+#else
+#define PNG_UNFILTER_AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define PNG_UNFILTER_NEON
+#include <arm_neon.h>
+#endif
+
+namespace GameEngine {
+
+	namespace {
+
+		const size_t BYTES_PER_PIXEL = 4;
+
+		typedef void(*UnfilterFunction)(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length);
+
+		//One set of filters for whichever instruction set we ended up with.
+		struct UnfilterFunctions {
+			const char* name;
+			UnfilterFunction sub;
+			UnfilterFunction up;
+			UnfilterFunction average;
+			UnfilterFunction paeth;
+		};
+
+		//Finish off whatever is left after the last full register, the same way picoPNG does it.
+		void subTail(unsigned char* recon, const unsigned char* scanline, size_t i, size_t length) {
+			for (; i < length; i++) recon[i] = scanline[i] + (i >= BYTES_PER_PIXEL ? recon[i - BYTES_PER_PIXEL] : 0);
+		}
+
+		void upTail(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t i, size_t length) {
+			for (; i < length; i++) recon[i] = scanline[i] + precon[i];
+		}
+
+		//Whole pixels get moved in and out of registers through an int, since the rows aren't aligned to anything.
+		unsigned int loadPixel(const unsigned char* p) {
+			unsigned int value;
+			memcpy(&value, p, BYTES_PER_PIXEL);
+			return value;
+		}
+
+		void storePixel(unsigned char* p, unsigned int value) {
+			memcpy(p, &value, BYTES_PER_PIXEL);
+		}
+
+#if defined(PNG_UNFILTER_SSE2)
+
+		void upSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length) {
+			size_t i = 0;
+			for (; i + 16 <= length; i += 16) {
+				__m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+				__m128i b = _mm_loadu_si128((const __m128i*)(precon + i));
+				_mm_storeu_si128((__m128i*)(recon + i), _mm_add_epi8(x, b));
+			}
+			upTail(recon, scanline, precon, i, length);
+		}
+
+		PNG_UNFILTER_AVX2_FUNCTION void upAVX2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length) {
+			size_t i = 0;
+			for (; i + 32 <= length; i += 32) {
+				__m256i x = _mm256_loadu_si256((const __m256i*)(scanline + i));
+				__m256i b = _mm256_loadu_si256((const __m256i*)(precon + i));
+				_mm256_storeu_si256((__m256i*)(recon + i), _mm256_add_epi8(x, b));
+			}
+			upTail(recon, scanline, precon, i, length);
+		}
+
+		void subSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* /*precon*/, size_t length) {
+			//Sub is a running total of each channel along the row. Inside 16 bytes (4 pixels) we add each
+			//pixel to the one after it, then each pair to the pair after it, and then carry in the last pixel of the block before.
+			__m128i last = _mm_setzero_si128();
+			size_t i = 0;
+			for (; i + 16 <= length; i += 16) {
+				__m128i x = _mm_loadu_si128((const __m128i*)(scanline + i));
+				x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+				x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+				x = _mm_add_epi8(x, last);
+				_mm_storeu_si128((__m128i*)(recon + i), x);
+				last = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+			}
+			subTail(recon, scanline, i, length);
+		}
+
+		void averageSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length) {
+			//_mm_avg_epu8 rounds up, PNG rounds down, so we take 1 off wherever a + b was odd.
+			const __m128i ones = _mm_set1_epi8(1);
+			__m128i a = _mm_setzero_si128();
+			for (size_t i = 0; i < length; i += BYTES_PER_PIXEL) {
+				__m128i b = _mm_cvtsi32_si128(loadPixel(precon + i));
+				__m128i x = _mm_cvtsi32_si128(loadPixel(scanline + i));
+				__m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), ones));
+				a = _mm_add_epi8(x, average);
+				storePixel(recon + i, _mm_cvtsi128_si32(a));
+			}
+		}
+
+		__m128i abs16(__m128i x) {
+			return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+		}
+
+		__m128i select(__m128i mask, __m128i ifTrue, __m128i ifFalse) {
+			return _mm_or_si128(_mm_and_si128(mask, ifTrue), _mm_andnot_si128(mask, ifFalse));
+		}
+
+		void paethSSE2(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length) {
+			//The distances can go past 255, so each channel gets widened to 16 bits.
+			//a is the pixel to the left, b is the one above, c is above and to the left.
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i byteMask = _mm_set1_epi16(0xFF);
+			__m128i a = zero;
+			__m128i c = zero;
+			for (size_t i = 0; i < length; i += BYTES_PER_PIXEL) {
+				__m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128(loadPixel(precon + i)), zero);
+				__m128i x = _mm_unpacklo_epi8(_mm_cvtsi32_si128(loadPixel(scanline + i)), zero);
+
+				//p = a + b - c, so |p - a| = |b - c|, |p - b| = |a - c| and |p - c| = |(b - c) + (a - c)|.
+				__m128i pa = _mm_sub_epi16(b, c);
+				__m128i pb = _mm_sub_epi16(a, c);
+				__m128i pc = abs16(_mm_add_epi16(pa, pb));
+				pa = abs16(pa);
+				pb = abs16(pb);
+
+				//Ties go to a, then b, then c.
+				__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+				__m128i nearest = select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+				a = _mm_and_si128(_mm_add_epi16(x, nearest), byteMask);
+				storePixel(recon + i, _mm_cvtsi128_si32(_mm_packus_epi16(a, a)));
+				c = b;
+			}
+		}
+
+		bool cpuHasAVX2() {
+#if defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7) return false;
+			//The CPU has to support it, and the OS has to save the big registers when it switches threads.
+			__cpuid(info, 1);
+			bool osSavesAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+			if (!osSavesAVX) return false;
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			return __builtin_cpu_supports("avx2") != 0;
+#endif
+		}
+
+		UnfilterFunctions pickFunctions() {
+			if (cpuHasAVX2()) {
+				//Only Up is wider, the others have to go one pixel at a time anyway.
+				return { "AVX2", subSSE2, upAVX2, averageSSE2, paethSSE2 };
+			}
+			return { "SSE2", subSSE2, upSSE2, averageSSE2, paethSSE2 };
+		}
+
+#elif defined(PNG_UNFILTER_NEON)
+
+		uint8x8_t loadPixelNEON(const unsigned char* p) {
+			return vcreate_u8(loadPixel(p));
+		}
+
+		void storePixelNEON(unsigned char* p, uint8x8_t value) {
+			storePixel(p, vget_lane_u32(vreinterpret_u32_u8(value), 0));
+		}
+
+		void upNEON(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length) {
+			size_t i = 0;
+			for (; i + 16 <= length; i += 16) {
+				vst1q_u8(recon + i, vaddq_u8(vld1q_u8(scanline + i), vld1q_u8(precon + i)));
+			}
+			upTail(recon, scanline, precon, i, length);
+		}
+
+		void subNEON(unsigned char* recon, const unsigned char* scanline, const unsigned char* /*precon*/, size_t length) {
+			//Same running total trick as the SSE2 version, vextq_u8 with zeros shifts whole pixels along.
+			const uint8x16_t zero = vdupq_n_u8(0);
+			uint8x16_t last = zero;
+			size_t i = 0;
+			for (; i + 16 <= length; i += 16) {
+				uint8x16_t x = vld1q_u8(scanline + i);
+				x = vaddq_u8(x, vextq_u8(zero, x, 12));
+				x = vaddq_u8(x, vextq_u8(zero, x, 8));
+				x = vaddq_u8(x, last);
+				vst1q_u8(recon + i, x);
+				last = vreinterpretq_u8_u32(vdupq_n_u32(vgetq_lane_u32(vreinterpretq_u32_u8(x), 3)));
+			}
+			subTail(recon, scanline, i, length);
+		}
+
+		void averageNEON(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length) {
+			//vhadd rounds down, which is exactly what PNG wants.
+			uint8x8_t a = vdup_n_u8(0);
+			for (size_t i = 0; i < length; i += BYTES_PER_PIXEL) {
+				a = vadd_u8(loadPixelNEON(scanline + i), vhadd_u8(a, loadPixelNEON(precon + i)));
+				storePixelNEON(recon + i, a);
+			}
+		}
+
+		void paethNEON(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t length) {
+			int16x8_t a = vdupq_n_s16(0);
+			int16x8_t c = a;
+			for (size_t i = 0; i < length; i += BYTES_PER_PIXEL) {
+				int16x8_t b = vreinterpretq_s16_u16(vmovl_u8(loadPixelNEON(precon + i)));
+				int16x8_t x = vreinterpretq_s16_u16(vmovl_u8(loadPixelNEON(scanline + i)));
+
+				int16x8_t pa = vsubq_s16(b, c);
+				int16x8_t pb = vsubq_s16(a, c);
+				int16x8_t pc = vabsq_s16(vaddq_s16(pa, pb));
+				pa = vabsq_s16(pa);
+				pb = vabsq_s16(pb);
+
+				int16x8_t smallest = vminq_s16(pc, vminq_s16(pa, pb));
+				int16x8_t nearest = vbslq_s16(vceqq_s16(smallest, pa), a, vbslq_s16(vceqq_s16(smallest, pb), b, c));
+
+				//Narrowing keeps the low byte, which wraps around the same way the scalar code does.
+				uint8x8_t result = vmovn_u16(vreinterpretq_u16_s16(vaddq_s16(x, nearest)));
+				storePixelNEON(recon + i, result);
+				a = vreinterpretq_s16_u16(vmovl_u8(result));
+				c = b;
+			}
+		}
+
+		UnfilterFunctions pickFunctions() {
+			return { "NEON", subNEON, upNEON, averageNEON, paethNEON };
+		}
+
+#else
+
+		UnfilterFunctions pickFunctions() {
+			return { "none", nullptr, nullptr, nullptr, nullptr };
+		}
+
+#endif
+
+		const UnfilterFunctions& getFunctions() {
+			//Only checks the CPU the first time, and it's safe if two loading threads get here at once.
+			static const UnfilterFunctions functions = pickFunctions();
+			return functions;
+		}
+
+	}
+
+	bool PNGUnfilter::unFilterScanlineRGBA8(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, unsigned long filterType, size_t length) {
+		const UnfilterFunctions& functions = getFunctions();
+		//The first row has nothing above it, that only happens once per image so it isn't worth its own versions.
+		if (length % BYTES_PER_PIXEL != 0 || (precon == nullptr && filterType != 1)) {
+			return false;
+		}
+
+		UnfilterFunction function = nullptr;
+		switch (filterType) {
+			case 1: function = functions.sub; break;
+			case 2: function = functions.up; break;
+			case 3: function = functions.average; break;
+			case 4: function = functions.paeth; break;
+		}
+		if (function == nullptr) {
+			return false;
+		}
+
+		function(recon, scanline, precon, length);
+		return true;
+	}
+
+	const char* PNGUnfilter::getInstructionSet() {
+		return getFunctions().name;
+	}
+
+}
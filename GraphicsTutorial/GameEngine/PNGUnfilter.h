@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+namespace GameEngine {
+
+	/*PNG stores every row "filtered": each byte is saved as the difference from a guess made
+	out of the pixel to the left, the pixel above, or both. picoPNG undoes that one byte at a time,
+	which is most of the time spent decoding big sheets after inflate.
+
+	This does the same thing with SIMD for rows that are 4 bytes per pixel (8 bit RGBA, which is
+	what all of our textures are), one whole pixel per instruction instead of one byte.
+	Up has no dependency on the pixel to the left, so it does 16 bytes (32 with AVX2) at a time.
+	The instruction set is picked once at runtime: AVX2 or SSE2 on x86, NEON on ARM.*/
+
+	class PNGUnfilter
+	{
+	public:
+		//Undoes filterType (1 = Sub, 2 = Up, 3 = Average, 4 = Paeth) on one row of 4 byte pixels.
+		//precon is the row above (already unfiltered), or nullptr for the first row.
+		//Returns false if there's no SIMD version for this case, and the caller has to do it the normal way.
+		static bool unFilterScanlineRGBA8(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, unsigned long filterType, size_t length);
+
+		//"AVX2", "SSE2", "NEON" or "none", handy for printing next to load times.
+		static const char* getInstructionSet();
+	};
+
+}
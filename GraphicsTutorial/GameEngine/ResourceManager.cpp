@@ -2,8 +2,68 @@
 
 namespace GameEngine {
 	TextureCache ResourceManager::_textureCache;
+	std::map<std::string, TextureAtlas> ResourceManager::_atlasMap;
 
-	GLTexture ResourceManager::getTexture(std::string texturePath) {
-		return _textureCache.getTexture(texturePath);
+	GLTexture ResourceManager::getTexture(std::string_view texturePath, const TextureOptions& options) {
+		return _textureCache.getTexture(texturePath, options);
+	}
+
+	TextureHandle ResourceManager::loadTexture(std::string_view texturePath, const TextureOptions& options) {
+		return _textureCache.loadTexture(texturePath, options);
+	}
+
+	TextureHandle ResourceManager::loadTextureAsync(std::string_view texturePath, const TextureOptions& options) {
+		return _textureCache.loadTextureAsync(texturePath, options);
+	}
+
+	std::vector<TextureHandle> ResourceManager::loadTextureDirectoryAsync(const std::string& folderPath, const TextureOptions& options) {
+		return _textureCache.loadDirectoryAsync(folderPath, options);
+	}
+
+	const GLTexture& ResourceManager::getTexture(TextureHandle handle) {
+		return _textureCache.getTexture(handle);
+	}
+
+	bool ResourceManager::isTextureLoaded(TextureHandle handle) {
+		return _textureCache.isLoaded(handle);
+	}
+
+	void ResourceManager::updateTextureLoading(float maxMilliseconds) {
+		_textureCache.update(maxMilliseconds);
+	}
+
+	void ResourceManager::finishTextureLoading() {
+		_textureCache.finishLoading();
+	}
+
+	void ResourceManager::releaseTexture(TextureHandle handle) {
+		_textureCache.releaseTexture(handle);
+	}
+
+	void ResourceManager::setTextureMemoryBudget(size_t bytes) {
+		_textureCache.setMemoryBudget(bytes);
+	}
+
+	size_t ResourceManager::getTextureMemoryUsed() {
+		return _textureCache.getMemoryUsed();
+	}
+
+	size_t ResourceManager::getTextureMemoryHighWater() {
+		return _textureCache.getMemoryHighWater();
+	}
+
+	void ResourceManager::printTextureMemoryReport() {
+		_textureCache.printMemoryReport();
+	}
+
+	const TextureAtlas& ResourceManager::getTextureAtlas(const std::string& xmlPath) {
+		auto mit = _atlasMap.find(xmlPath);
+		if (mit == _atlasMap.end()) {
+			//operator[] makes an empty atlas in the map for us, then we load right into it.
+			TextureAtlas& atlas = _atlasMap[xmlPath];
+			atlas.init(xmlPath);
+			return atlas;
+		}
+		return mit->second;
 	}
 }
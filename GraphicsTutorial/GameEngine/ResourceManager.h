@@ -1,7 +1,11 @@
 #pragma once
 #include "TextureCache.h"
+#include "TextureAtlas.h"
 
+#include <map>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace GameEngine {
 
@@ -10,10 +14,32 @@ namespace GameEngine {
 	class ResourceManager
 	{
 	public:
-		static GLTexture getTexture(std::string texturePath);
+		//options (mipmaps, filtering, wrapping, premultiplied alpha) only count the first time a texture is loaded.
+		static GLTexture getTexture(std::string_view texturePath, const TextureOptions& options = TextureOptions());
+		//Look the path up once with this, then draw with getTexture(handle), which is just an array lookup.
+		static TextureHandle loadTexture(std::string_view texturePath, const TextureOptions& options = TextureOptions());
+
+		//Background loading, see TextureCache for how it works.
+		static TextureHandle loadTextureAsync(std::string_view texturePath, const TextureOptions& options = TextureOptions());
+		static std::vector<TextureHandle> loadTextureDirectoryAsync(const std::string& folderPath, const TextureOptions& options = TextureOptions());
+		static const GLTexture& getTexture(TextureHandle handle);
+		static bool isTextureLoaded(TextureHandle handle);
+		//Call once a frame from the game loop.
+		static void updateTextureLoading(float maxMilliseconds);
+		static void finishTextureLoading();
+		//Takes away the reference loadTexture or loadTextureAsync added, see TextureCache for the memory budget.
+		static void releaseTexture(TextureHandle handle);
+		static void setTextureMemoryBudget(size_t bytes);
+		static size_t getTextureMemoryUsed();
+		static size_t getTextureMemoryHighWater();
+		static void printTextureMemoryReport();
+
+		//Atlases get parsed the first time they're asked for, after that we just hand back the same one.
+		static const TextureAtlas& getTextureAtlas(const std::string& xmlPath);
 
 	private:
 		static TextureCache _textureCache;
+		static std::map<std::string, TextureAtlas> _atlasMap;
 	};
 
 }
\ No newline at end of file
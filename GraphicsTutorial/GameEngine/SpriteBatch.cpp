@@ -1,12 +1,40 @@
 #include "SpriteBatch.h"
 
-#include <algorithm> //for a sorting function
+#include <glm/gtc/matrix_transform.hpp> //glm::translate, glm::scale
+
+#include <algorithm> //std::min, std::max
+#include <cstring> //memcpy
+#include <utility> //std::swap
 
 namespace GameEngine {
 
+	//emplace_back takes its parameters by reference, so these need a definition somewhere, not just a value.
+	const int SpriteBatch::VERTICES_PER_QUAD;
+	const int SpriteBatch::INDICES_PER_QUAD;
+	const int SpriteBatch::INITIAL_STREAM_QUADS;
+
+	Glyph::Glyph(const glm::vec4& DestRect, const glm::vec4& UvRect, GLuint Texture, float Depth, const Color& SpriteColor, GLint Layer, BlendMode Blend) :
+		texture(Texture),
+		depth(Depth),
+		layer(Layer),
+		blendMode(Blend),
+		destRect(DestRect),
+		uvRect(UvRect),
+		color(SpriteColor)
+	{
+	}
+
 	SpriteBatch::SpriteBatch() :
-		_vbo(0),
-		_vao(0)
+		_streamQuads(0),
+		_useTextureArrays(false),
+		_useInstancing(false),
+		_useBaseInstance(false),
+		_vao(0),
+		_ibo(0),
+		_indexBufferQuads(0),
+		_numDrawCalls(0),
+		_numBlendChanges(0),
+		_vertexOrigin(0.0f)
 	{
 	}
 
@@ -15,7 +43,17 @@ namespace GameEngine {
 	{
 	}
 
-	void SpriteBatch::init() {
+	void SpriteBatch::init(bool useTextureArrays /* false */, bool useInstancing /* false */) {
+		_useTextureArrays = useTextureArrays;
+		//glVertexAttribDivisor (one value per sprite instead of per vertex) is openGL 3.3.
+		_useInstancing = useInstancing && GLEW_VERSION_3_3;
+		_useBaseInstance = _useInstancing && (GLEW_VERSION_4_2 || GLEW_ARB_base_instance);
+		_streamQuads = INITIAL_STREAM_QUADS;
+		_vertexStream.init(_streamQuads * getBytesPerQuad());
+		//Instances carry their own layer, so only normal vertices need the extra stream.
+		if (_useTextureArrays && !_useInstancing) {
+			_layerStream.init(_streamQuads * VERTICES_PER_QUAD * sizeof(GLushort));
+		}
 		createVertexArray();
 	}
 
@@ -23,46 +61,190 @@ namespace GameEngine {
 		_sortType = sortType;
 		//clear out any left over data from the last call
 		_renderBatches.clear(); 
-		_glyphs.clear();
+		_recorder.clear();
+		for (auto& recorder : _recorders) {
+			recorder->clear();
+		}
+		_numDrawCalls = 0;
+		_numBlendChanges = 0;
 	}
 
 	void SpriteBatch::end() {
-		sortGlyphs();
-		createRenderBatches();
+		//Now that the glyphs won't grow anymore, it's safe to point at them. Ours come first, then each
+		//recorder's in order, so the threads finishing in a different order doesn't change anything.
+		//resize keeps the old capacity around too, so this doesn't allocate at steady state either.
+		_glyphPointers.resize(getNumGlyphs());
+		int cg = 0; //current glyph
+		for (Glyph& glyph : _recorder._glyphs) {
+			_glyphPointers[cg++] = &glyph;
+		}
+		for (auto& recorder : _recorders) {
+			for (Glyph& glyph : recorder->_glyphs) {
+				_glyphPointers[cg++] = &glyph;
+			}
+		}
+
+		//Nothing to sort in an empty frame (everything got culled, or nothing was drawn).
+		if (!_glyphPointers.empty()) {
+			sortGlyphs();
+		}
+
+		//No vertex array means init() was never called, so there's no gpu buffer to write into.
+		//We still build everything, just into a normal vector (see getVertices).
+		if (_vao == 0) {
+			_vertices.resize(_glyphPointers.size() * VERTICES_PER_QUAD);
+			createRenderBatches(_vertices.data(), nullptr, nullptr, 0);
+			return;
+		}
+
+		if (_glyphPointers.empty()) {
+			return;
+		}
+
+		//If this frame has more sprites than a section can hold, we need a bigger stream buffer.
+		//We at least double it so that a slowly growing sprite count doesn't do this every frame.
+		int numQuads = _glyphPointers.size();
+		if (numQuads > _streamQuads) {
+			_streamQuads = (numQuads > _streamQuads * 2) ? numQuads : _streamQuads * 2;
+			_vertexStream.resize(_streamQuads * getBytesPerQuad());
+			if (_useTextureArrays && !_useInstancing) {
+				_layerStream.resize(_streamQuads * VERTICES_PER_QUAD * sizeof(GLushort));
+			}
+			//The stream buffers are brand new buffers now, so the vertex array has to point at them again.
+			createVertexArray();
+		}
+
+		//The glyphs write their vertices straight into the gpu's memory. No vector, no extra copy.
+		void* data = _vertexStream.map(numQuads * getBytesPerQuad());
+		GLuint firstQuad = _vertexStream.getSectionOffset() / getBytesPerQuad();
+
+		if (_useInstancing) {
+			createRenderBatches(nullptr, nullptr, (SpriteInstance*)data, firstQuad);
+			_vertexStream.unmap();
+			return;
+		}
+
+		//The layer stream has to be mapped every frame (even with no TextureArray sprites)
+		//so that it stays on the same section as the vertex stream.
+		GLushort* layers = nullptr;
+		if (_useTextureArrays) {
+			layers = (GLushort*)_layerStream.map(numQuads * VERTICES_PER_QUAD * sizeof(GLushort));
+		}
+
+		createRenderBatches((SpriteVertex*)data, layers, nullptr, firstQuad);
+
+		_vertexStream.unmap();
+		if (_useTextureArrays) {
+			_layerStream.unmap();
+		}
 	}
 
-	void SpriteBatch::draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, float depth, const Color& color) {
-		//draw is going to want to add a glyph to a vector of glyphs.
-		//So using pointers because it's less memory. The arrow points to the actual Glyph. 
+	void SpriteBatch::draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, float depth, const Color& color, BlendMode blendMode) {
+		_recorder.draw(destRect, uvRect, texture, depth, color, blendMode);
+	}
 
-		Glyph* newGlyph = new Glyph;
-		newGlyph->texture = texture;
-		newGlyph->depth = depth;
-		
-		//Basically, this is taking the place of our code that we set manually in sprite.cpp
-		//and we can call spritebatch for any sprite that we have as long as we give spritebatch
-		//the positions, uv coordinates (the coordinates of the sprite relative to itself,
-		//from 0 to 1), dimensions, texture, color, depth, and color vector.
-		
-		//Also, because we are using glm::vec4, we have the methods x, y, z, and w. We are storing
-		//coordinates in x and y, and height and width in z and w. 
-		newGlyph->topLeft.color = color;
-		newGlyph->topLeft.setPosition(destRect.x, destRect.y + destRect.w);
-		newGlyph->topLeft.setUV(uvRect.x, uvRect.y + uvRect.w);
-		
-		newGlyph->bottomLeft.color = color;
-		newGlyph->bottomLeft.setPosition(destRect.x, destRect.y);
-		newGlyph->bottomLeft.setUV(uvRect.x, uvRect.y);
-	
-		newGlyph->bottomRight.color = color;
-		newGlyph->bottomRight.setPosition(destRect.x + destRect.z, destRect.y);
-		newGlyph->bottomRight.setUV(uvRect.x + uvRect.z, uvRect.y);
-		
-		newGlyph->topRight.color = color;
-		newGlyph->topRight.setPosition(destRect.x + destRect.z, destRect.y + destRect.w);
-		newGlyph->topRight.setUV(uvRect.x + uvRect.z, uvRect.y + uvRect.w);
+	void SpriteBatch::draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, GLint layer, float depth, const Color& color, BlendMode blendMode) {
+		_recorder.draw(destRect, uvRect, texture, layer, depth, color, blendMode);
+	}
+
+	void SpriteBatch::setCullRect(const glm::vec4& cullRect) {
+		_recorder._cullRect = cullRect;
+		_recorder._useCullRect = true;
+		for (auto& recorder : _recorders) {
+			recorder->_cullRect = cullRect;
+			recorder->_useCullRect = true;
+		}
+	}
 
-		_glyphs.push_back(newGlyph); //adding it to our vector of glyphs.
+	void SpriteBatch::clearCullRect() {
+		_recorder._useCullRect = false;
+		for (auto& recorder : _recorders) {
+			recorder->_useCullRect = false;
+		}
+	}
+
+	void SpriteBatch::setNumRecorders(int numRecorders) {
+		_recorders.resize(numRecorders);
+		for (auto& recorder : _recorders) {
+			if (!recorder) {
+				recorder = std::make_unique<SpriteRecorder>();
+				//New ones cull the same as everyone else.
+				recorder->_cullRect = _recorder._cullRect;
+				recorder->_useCullRect = _recorder._useCullRect;
+			}
+		}
+	}
+
+	glm::mat4 SpriteBatch::getVertexTransform() const {
+		if (_useInstancing) {
+			return glm::mat4(1.0f);
+		}
+		//Scale first (it's on the right), then move.
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(_vertexOrigin, 0.0f));
+		return glm::scale(transform, glm::vec3(1.0f / SpriteVertex::POSITION_SCALE, 1.0f / SpriteVertex::POSITION_SCALE, 1.0f));
+	}
+
+	int SpriteBatch::getNumGlyphs() const {
+		int numGlyphs = _recorder.getNumGlyphs();
+		for (auto& recorder : _recorders) {
+			numGlyphs += recorder->getNumGlyphs();
+		}
+		return numGlyphs;
+	}
+
+	int SpriteBatch::getNumCulled() const {
+		int numCulled = _recorder.getNumCulled();
+		for (auto& recorder : _recorders) {
+			numCulled += recorder->getNumCulled();
+		}
+		return numCulled;
+	}
+
+	SpriteRecorder::SpriteRecorder() :
+		_cullRect(0.0f),
+		_useCullRect(false),
+		_numCulled(0)
+	{
+	}
+
+	void SpriteRecorder::draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, float depth, const Color& color, BlendMode blendMode) {
+		//Off screen sprites stop here, see SpriteBatch::setCullRect.
+		if (isCulled(destRect)) {
+			return;
+		}
+		//draw is going to want to add a glyph to our vector of glyphs. emplace_back constructs it
+		//right inside the vector, so once the vector is big enough this doesn't allocate anything.
+		_glyphs.emplace_back(destRect, uvRect, texture, depth, color, -1, blendMode);
+	}
+
+	void SpriteRecorder::draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, GLint layer, float depth, const Color& color, BlendMode blendMode) {
+		if (isCulled(destRect)) {
+			return;
+		}
+		_glyphs.emplace_back(destRect, uvRect, texture, depth, color, layer, blendMode);
+	}
+
+	void SpriteRecorder::clear() {
+		_glyphs.clear();
+		_numCulled = 0;
+	}
+
+	bool SpriteRecorder::isCulled(const glm::vec4& destRect) {
+		if (!_useCullRect) {
+			return false;
+		}
+		//Two rectangles overlap unless one is completely to the left of, right of, above or below the other.
+		//A sprite with a negative width or height (flipped by its destRect) still works, min and max sort the edges out.
+		float left = std::min(destRect.x, destRect.x + destRect.z);
+		float right = std::max(destRect.x, destRect.x + destRect.z);
+		float bottom = std::min(destRect.y, destRect.y + destRect.w);
+		float top = std::max(destRect.y, destRect.y + destRect.w);
+		if (right < _cullRect.x || left > _cullRect.x + _cullRect.z ||
+			top < _cullRect.y || bottom > _cullRect.y + _cullRect.w) {
+			_numCulled++;
+			return true;
+		}
+		return false;
 	}
 
 	void SpriteBatch::renderBatch() {
@@ -70,78 +252,180 @@ namespace GameEngine {
 		//Have to bine the vertex array before we can draw anything.
 		glBindVertexArray(_vao);
 
+		//Somebody else could have changed the blend function since last frame, so the first batch always sets it.
+		glEnable(GL_BLEND);
 		for (int i = 0; i < _renderBatches.size(); i++) {
-			glBindTexture(GL_TEXTURE_2D, _renderBatches[i].texture);
-
-			glDrawArrays(GL_TRIANGLES, _renderBatches[i].offset, _renderBatches[i].numVertices);
+			if (i == 0 || _renderBatches[i].blendMode != _renderBatches[i - 1].blendMode) {
+				setBlendMode(_renderBatches[i].blendMode);
+				_numBlendChanges++;
+			}
+			glBindTexture(_renderBatches[i].target, _renderBatches[i].texture);
+
+			if (_useInstancing) {
+				//The batch still counts in indices, 6 per sprite, so dividing gets us back to sprites.
+				//Each instance is a 4 vertex triangle strip, the shader works out which corner is which.
+				GLuint firstInstance = _renderBatches[i].offset / INDICES_PER_QUAD;
+				GLsizei numInstances = _renderBatches[i].numIndices / INDICES_PER_QUAD;
+				if (_useBaseInstance) {
+					glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, VERTICES_PER_QUAD, numInstances, firstInstance);
+				} else {
+					setInstancePointers(firstInstance);
+					glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, VERTICES_PER_QUAD, numInstances);
+				}
+			} else {
+				//The last parameter is where to start in the index buffer, and it wants it in bytes.
+				glDrawElements(GL_TRIANGLES, _renderBatches[i].numIndices, GL_UNSIGNED_INT,
+					(void*)(_renderBatches[i].offset * sizeof(GLuint)));
+			}
+			_numDrawCalls++;
 		}
 
 		glBindVertexArray(0); //unbindng
-	}
 
-	void SpriteBatch::createRenderBatches() {
-		std::vector <Vertex> vertices;
-		//This just speeds things up a little bit, because we know the size it should be.
-		vertices.resize(_glyphs.size() * 6);
-
-		if (_glyphs.empty()) {
-			return;
+		//Now the gpu knows about every draw that reads this frame's section of the stream buffer,
+		//so we can put a fence after them. We won't write to this section again until it's signaled.
+		if (!_renderBatches.empty()) {
+			_vertexStream.fence();
+			if (_useTextureArrays && !_useInstancing) {
+				_layerStream.fence();
+			}
 		}
+	}
+
+	void SpriteBatch::createRenderBatches(SpriteVertex* vertices, GLushort* layers, SpriteInstance* instances, GLuint firstQuad) {
 		//So what we could do is create a RenderBatch and then use push_back
 		//to put it in _renderBatches. However, that variable is temporary
 		//and it would get destroyed with the stack. Instead of wasting that resource,
 		//we can use emplace_back, which takes out that intermediate step and creates the 
 		//object within _renderBatches using the parameters we give it.
 
-		//Since this is the first batch, the offset is 0, we always have 6 vertices for a quad
-		//and we use the first texture in _glyphs.
-
 		int cv = 0; //current vertex
-		int offset = 0;
-		_renderBatches.emplace_back(offset, 6, _glyphs[0]->texture);
-		vertices[cv++] = _glyphs[0]->topLeft;
-		vertices[cv++] = _glyphs[0]->bottomLeft;
-		vertices[cv++] = _glyphs[0]->bottomRight;
-		vertices[cv++] = _glyphs[0]->bottomRight;
-		vertices[cv++] = _glyphs[0]->topRight;
-		vertices[cv++] = _glyphs[0]->topLeft;
-		offset += 6;
-
-		//We have to start at one because we already did the first batch
-		for (int cg = 1; cg < _glyphs.size(); cg++) { //current glyph
-			//We only want to emplace_back to the renderbatch unless
-			//the current texture is different from the previous texture.
-			//that way we can make multiple draw calls off the same vbo.
-			if (_glyphs[cg]->texture != _glyphs[cg - 1]->texture) {
-				_renderBatches.emplace_back(offset, 6, _glyphs[cg]->texture);
-			} else { //otherwise we just increase the number of vertices.
+		int offset = firstQuad * INDICES_PER_QUAD; //current index, starts where this frame's vertices start
+
+		for (int cg = 0; cg < _glyphPointers.size(); cg++) { //current glyph
+			//We only want to emplace_back a new renderbatch when this is the first glyph or
+			//the current texture or blend mode is different from the previous one. Otherwise the glyph
+			//just gets added onto the batch we already have, that way one texture run is one draw call.
+			if (cg == 0 || _glyphPointers[cg]->texture != _glyphPointers[cg - 1]->texture ||
+				_glyphPointers[cg]->blendMode != _glyphPointers[cg - 1]->blendMode) {
+				GLenum target = (_glyphPointers[cg]->layer >= 0) ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
+				_renderBatches.emplace_back(offset, INDICES_PER_QUAD, _glyphPointers[cg]->texture, target, _glyphPointers[cg]->blendMode);
+			} else { //otherwise we just increase the number of indices.
 				//Back will get us the last element.
-				_renderBatches.back().numVertices += 6;
+				_renderBatches.back().numIndices += INDICES_PER_QUAD;
 			}
-			//all of the vertices are getting placed in one vector,
+			//all of the vertices are getting placed in one buffer,
 			//but we can discern which vertices go with which texture 
 			//by their offsets.
+			if (instances != nullptr) {
+				createInstance(*_glyphPointers[cg], instances[cg]);
+			} else {
+				createQuadVertices(*_glyphPointers[cg], _vertexOrigin, &vertices[cv]);
+			}
+			if (layers != nullptr) {
+				//All 4 corners are in the same layer. Normal textures just get layer 0, the shader won't look at it.
+				GLushort layer = (_glyphPointers[cg]->layer >= 0) ? _glyphPointers[cg]->layer : 0;
+				for (int i = 0; i < VERTICES_PER_QUAD; i++) {
+					layers[cv + i] = layer;
+				}
+			}
+			cv += VERTICES_PER_QUAD;
+			offset += INDICES_PER_QUAD;
+		}
+	}
 
-			_renderBatches.emplace_back(0, 6, _glyphs[cg]->texture);
-			vertices[cv++] = _glyphs[cg]->topLeft;
-			vertices[cv++] = _glyphs[cg]->bottomLeft;
-			vertices[cv++] = _glyphs[cg]->bottomRight;
-			vertices[cv++] = _glyphs[cg]->bottomRight;
-			vertices[cv++] = _glyphs[cg]->topRight;
-			vertices[cv++] = _glyphs[cg]->topLeft;
-			offset += 6;
+	void SpriteBatch::setBlendMode(BlendMode blendMode) {
+		switch (blendMode) {
+			case BlendMode::ALPHA:
+				//Take the source alpha, and get the inverse
+				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+				break;
+			case BlendMode::PREMULTIPLIED:
+				//The color was already multiplied by the alpha when the texture was loaded.
+				glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+				break;
+			case BlendMode::ADDITIVE:
+				//Still scaled by alpha, so see through parts of the texture don't add anything.
+				glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+				break;
 		}
+	}
+
+	void SpriteBatch::createQuadVertices(const Glyph& glyph, const glm::vec2& origin, SpriteVertex* out) {
+		//Basically, this is taking the place of our code that we set manually in sprite.cpp
+		//and we can call spritebatch for any sprite that we have as long as we give spritebatch
+		//the positions, uv coordinates (the coordinates of the sprite relative to itself,
+		//from 0 to 1), dimensions, texture, color, depth, and color vector.
 
-		//we bind the vertex buffer object, so opengl knows where to send our data
-		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-		//there is probably some data still left in our vbo, and we don't want it anymore, so a fast way
-		//to write to our vbo would be to abandon it and have openGL create a new one for us, and we right to that
-		//this is called orphaning the data, we do that by passing in a nullptr for our data
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
-		//now we want to upload our vertex data to our vertex buffer object.
-		glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
-		//now we unbind our buffer.
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		//Also, because we are using glm::vec4, we have the methods x, y, z, and w. We are storing
+		//coordinates in x and y, and height and width in z and w. 
+		//Moving destRect instead of every corner is the same thing, and only has to be done once.
+		const glm::vec4 destRect(glyph.destRect.x - origin.x, glyph.destRect.y - origin.y, glyph.destRect.z, glyph.destRect.w);
+		const glm::vec4& uvRect = glyph.uvRect;
+
+		//topLeft
+		out[0].color = glyph.color;
+		out[0].setPosition(destRect.x, destRect.y + destRect.w);
+		out[0].setUV(uvRect.x, uvRect.y + uvRect.w);
+
+		//bottomLeft
+		out[1].color = glyph.color;
+		out[1].setPosition(destRect.x, destRect.y);
+		out[1].setUV(uvRect.x, uvRect.y);
+
+		//bottomRight
+		out[2].color = glyph.color;
+		out[2].setPosition(destRect.x + destRect.z, destRect.y);
+		out[2].setUV(uvRect.x + uvRect.z, uvRect.y);
+
+		//topRight
+		out[3].color = glyph.color;
+		out[3].setPosition(destRect.x + destRect.z, destRect.y + destRect.w);
+		out[3].setUV(uvRect.x + uvRect.z, uvRect.y + uvRect.w);
+	}
+
+	void SpriteBatch::createInstance(const Glyph& glyph, SpriteInstance& out) {
+		out.destRect = glyph.destRect;
+		out.uvRect = glyph.uvRect;
+		out.color = glyph.color;
+		out.layer = (glyph.layer >= 0) ? (float)glyph.layer : 0.0f;
+	}
+
+	void SpriteBatch::createQuadIndices(std::vector<GLuint>& indices, int numQuads) {
+		indices.resize(numQuads * INDICES_PER_QUAD);
+
+		//Same two triangles we used to send as 6 vertices: topLeft, bottomLeft, bottomRight
+		//and then bottomRight, topRight, topLeft. Just shifted over by 4 for every quad.
+		for (int i = 0; i < numQuads; i++) {
+			GLuint first = i * VERTICES_PER_QUAD;
+			GLuint* quad = &indices[i * INDICES_PER_QUAD];
+			quad[0] = first + 0;
+			quad[1] = first + 1;
+			quad[2] = first + 2;
+			quad[3] = first + 2;
+			quad[4] = first + 3;
+			quad[5] = first + 0;
+		}
+	}
+
+	void SpriteBatch::createIndexBuffer(int numQuads) {
+		//Grow by at least double so that a slowly growing sprite count doesn't rebuild this every frame.
+		if (numQuads < _indexBufferQuads * 2) {
+			numQuads = _indexBufferQuads * 2;
+		}
+
+		std::vector<GLuint> indices;
+		createQuadIndices(indices, numQuads);
+
+		//The element array buffer binding is part of the vertex array state, so we
+		//bind our vao first so that it keeps pointing at _ibo.
+		glBindVertexArray(_vao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+		//These never change once they are built, so we can use GL_STATIC_DRAW.
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+		glBindVertexArray(0);
+
+		_indexBufferQuads = numQuads;
 	}
 
 	void SpriteBatch::createVertexArray() {
@@ -153,66 +437,167 @@ namespace GameEngine {
 		}
 		glBindVertexArray(_vao);
 
-		if (_vbo == 0) {
-			glGenBuffers(1, &_vbo);
+		if (_useInstancing) {
+			//Every attribute moves on once per sprite (the divisor) instead of once per vertex.
+			//There's no index buffer, the shader makes the corners from gl_VertexID.
+			for (GLuint i = 0; i < 4; i++) {
+				glEnableVertexAttribArray(i);
+				glVertexAttribDivisor(i, 1);
+			}
+			setInstancePointers(0);
+			glBindVertexArray(0);
+			return;
 		}
-		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-		
-		glEnableVertexAttribArray(0);
-		glEnableVertexAttribArray(1);
-		glEnableVertexAttribArray(2);
-
-		//The size of the array (the second parameter) need to know the number of elements for each piece of data
-		//We are only using x and y coordinates, so there are 2 elements.
-		//The stride is the size of the vertex struct.
-
-		//This is the position attribute pointer
-		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
 
-		//This is the color attribute pointer
-		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, color));
+		glBindBuffer(GL_ARRAY_BUFFER, _vertexStream.getBufferId());
 
-		//This is the UV attribute pointer
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, uv));
+		if (_ibo == 0) {
+			glGenBuffers(1, &_ibo);
+		}
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+		
+		//The position, color and UV attribute pointers. Which types and sizes they are comes from
+		//SpriteVertex::ATTRIBUTES, so switching to PackedVertex doesn't change anything here.
+		setVertexAttributes<SpriteVertex>();
+
+		//The layer lives in its own buffer, so we bind that one before setting up its pointer.
+		//The attribute pointer remembers which buffer was bound when we called it.
+		if (_useTextureArrays) {
+			glBindBuffer(GL_ARRAY_BUFFER, _layerStream.getBufferId());
+			glEnableVertexAttribArray(3);
+			//GL_FALSE for normalized, so layer 5 shows up as 5.0 in the shader instead of 5/65535.
+			glVertexAttribPointer(3, 1, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(GLushort), (void*)0);
+		}
 		
 		//Now we need to unbind the vertex attribute array.
 		//This will disable all of our vretext attribute arrays (glDisableVertexAttribArray)
 		//It will also unbind our vbo
 		glBindVertexArray(0);
+
+		//Every section of the stream buffer needs its own indices, since the batch offsets point
+		//at wherever this frame's section starts.
+		int numQuads = _streamQuads * StreamBuffer::NUM_SECTIONS;
+		if (numQuads > _indexBufferQuads) {
+			createIndexBuffer(numQuads);
+		}
+	}
+
+	void SpriteBatch::setInstancePointers(GLuint firstInstance) {
+		glBindBuffer(GL_ARRAY_BUFFER, _vertexStream.getBufferId());
+
+		//Same numbers as the vertex attributes, so 1 is still the color and 3 is still the layer.
+		//destRect and uvRect are whole vec4s here, the shader does the x + width part.
+		size_t start = firstInstance * sizeof(SpriteInstance);
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(start + offsetof(SpriteInstance, destRect)));
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteInstance), (void*)(start + offsetof(SpriteInstance, color)));
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(start + offsetof(SpriteInstance, uvRect)));
+		glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(start + offsetof(SpriteInstance, layer)));
 	}
 
 	void SpriteBatch::sortGlyphs() {
-		//stable_sort ensures that a items that are sort keep their oringal position/order when comparing two items of the same value/type.
-		//stable_sort parameters take the beginning and end of the container,
-		//the the third parameter is predicate/comparatory which is a function that we pass in
-		//That function is what determines how to sort, what is greater than and what is less than
-		//If you're just using numeric values, you don't need to use a function for the third parameter.
-		switch (_sortType) {
-			case GlyphSortType::BACK_TO_FRONT:
-				
-				std::stable_sort(_glyphs.begin(), _glyphs.end(), compareBackToFront);
-				break;
+		//NONE means draw them in the order they were given to us, which _glyphPointers already is.
+		if (_sortType == GlyphSortType::NONE) {
+			return;
+		}
+
+		//Instead of std::stable_sort calling a compare function that has to follow two pointers every
+		//time, we give every glyph one 64 bit number that already sorts the way we want, and sort those.
+		//The top 32 bits are what we're sorting by (see createSortKey) and the bottom 32 bits are the
+		//glyph's index in _glyphPointers. Since the index is unique and goes up in the order glyphs were drawn,
+		//two glyphs with the same texture/depth keep their original order, same as stable_sort.
+		_sortKeys.resize(_glyphPointers.size());
+		for (size_t i = 0; i < _glyphPointers.size(); i++) {
+			_sortKeys[i] = ((uint64_t)createSortKey(*_glyphPointers[i], _sortType) << 32) | (uint64_t)(uint32_t)i;
+		}
+
+		radixSortKeys(_sortKeys, _sortScratch);
+
+		//The bottom 32 bits tell us which glyph ended up where. We still need the unsorted pointers
+		//while we're doing this, so the sorted ones go in a second vector and then the two swap.
+		_sortedPointers.resize(_sortKeys.size());
+		for (size_t i = 0; i < _sortKeys.size(); i++) {
+			_sortedPointers[i] = _glyphPointers[(uint32_t)_sortKeys[i]];
+		}
+		_glyphPointers.swap(_sortedPointers);
+	}
+
+	uint32_t SpriteBatch::createSortKey(const Glyph& glyph, GlyphSortType sortType) {
+		//A float's bits don't sort like the float does, because negative numbers have the sign bit set.
+		//Flipping the sign bit on positive numbers and flipping every bit on negative numbers fixes that,
+		//and then smaller depths always have smaller keys.
+		uint32_t depthBits;
+		memcpy(&depthBits, &glyph.depth, sizeof(depthBits));
+		uint32_t depthKey = (depthBits & 0x80000000) ? ~depthBits : (depthBits | 0x80000000);
+
+		switch (sortType) {
 			case GlyphSortType::FRONT_TO_BACK:
-				std::stable_sort(_glyphs.begin(), _glyphs.end(), compareFrontToBack);
-				break;
+				return depthKey;
+			case GlyphSortType::BACK_TO_FRONT:
+				//Flipping the bits turns smallest first into biggest first.
+				return ~depthKey;
 			case GlyphSortType::TEXTURE:
-				std::stable_sort(_glyphs.begin(), _glyphs.end(), compareTexture);
-				break;
+				//The blend mode goes in the top 2 bits, so every sprite with the same blend mode ends up
+				//together and we only switch blend functions once or twice a frame. Normal alpha sprites
+				//come first and additive ones last. Textures have always been sorted biggest id first, so
+				//we keep doing that with the other 30 bits (openGL hands out ids counting up from 1,
+				//so we'd need a billion textures before two of them shared a key).
+				return ((uint32_t)glyph.blendMode << 30) | (~glyph.texture & 0x3FFFFFFF);
+			default:
+				return 0;
 		}
-		
 	}
 
-	//we have to use the arrows because the inputs are pointers
-	bool SpriteBatch::compareFrontToBack(Glyph* a, Glyph* b) {
-		return (a->depth < b->depth);
-	}
-	
-	bool SpriteBatch::compareBackToFront(Glyph* a, Glyph* b) {
-		return (a->depth > b->depth);
-	}
-	
-	bool SpriteBatch::compareTexture(Glyph* a, Glyph* b) {
-		return (a->texture > b->texture);
+	void SpriteBatch::radixSortKeys(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch) {
+		//This is an LSD (least significant digit) radix sort. It sorts by one byte at a time, starting
+		//with the lowest byte, and every pass is stable, so after the last pass everything is in order.
+		//We only need the top 4 bytes. The bottom 4 are the glyph indices, which are already in order.
+		const int FIRST_BYTE = 4;
+		const int NUM_BYTES = 8 - FIRST_BYTE;
+
+		//Zero or one key is already sorted, and the byte skip below looks at keys[0].
+		if (keys.size() < 2) {
+			return;
+		}
+
+		scratch.resize(keys.size());
+
+		//Count how many keys have each value (0-255) for each byte, all in one pass over the keys.
+		size_t counts[NUM_BYTES][256] = {};
+		for (size_t i = 0; i < keys.size(); i++) {
+			for (int b = 0; b < NUM_BYTES; b++) {
+				counts[b][(keys[i] >> ((FIRST_BYTE + b) * 8)) & 0xFF]++;
+			}
+		}
+
+		uint64_t* src = keys.data();
+		uint64_t* dst = scratch.data();
+		for (int b = 0; b < NUM_BYTES; b++) {
+			int shift = (FIRST_BYTE + b) * 8;
+
+			//If every key has the same value for this byte (like the top bytes of small texture ids),
+			//this pass wouldn't move anything, so we skip it.
+			if (counts[b][(src[0] >> shift) & 0xFF] == keys.size()) {
+				continue;
+			}
+
+			//Turn the counts into where each value starts in the output.
+			size_t offsets[256];
+			size_t total = 0;
+			for (int v = 0; v < 256; v++) {
+				offsets[v] = total;
+				total += counts[b][v];
+			}
+
+			for (size_t i = 0; i < keys.size(); i++) {
+				dst[offsets[(src[i] >> shift) & 0xFF]++] = src[i];
+			}
+			std::swap(src, dst);
+		}
+
+		//If we ended up with the sorted keys in scratch, swap the vectors so keys has them.
+		if (src != keys.data()) {
+			keys.swap(scratch);
+		}
 	}
 
 }
\ No newline at end of file
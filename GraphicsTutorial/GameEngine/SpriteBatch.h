@@ -3,8 +3,11 @@
 #include <GL/glew.h>
 #include <glm\glm.hpp> //vec4
 #include <vector>
+#include <cstdint>
+#include <memory>
 
 #include "Vertex.h"
+#include "StreamBuffer.h"
 
 /*This class is so we can batch a multiple sprites together in one vbo
 and a single draw call. Do this for each individual sprite is really
@@ -20,6 +23,14 @@ namespace GameEngine {
 		BACK_TO_FRONT,
 		TEXTURE
 	};
+
+	//How a sprite gets mixed with what's already on the screen. Each one is a different glBlendFunc,
+	//so sprites with different blend modes can't be in the same draw call.
+	enum class BlendMode : uint8_t {
+		ALPHA, //the normal see through blending, for textures that weren't premultiplied
+		PREMULTIPLIED, //for textures loaded with TextureOptions::premultiplyAlpha. The color has to be premultiplied too.
+		ADDITIVE //adds its color to the screen, good for particles, fire and glows
+	};
 	
 	//Sprite structure and properties like depth (layer), texture, 
 	//six vertices for quad, and more, this is good for sorting. So
@@ -27,38 +38,103 @@ namespace GameEngine {
 	//alike can be drawn together, so that we can minimize the number of
 	//draw calls and texture switching.
 	struct Glyph {
+		Glyph() {}
+		//The constructor takes the same arguments that SpriteBatch::draw takes,
+		//so draw can build the glyph right inside our vector with emplace_back.
+		Glyph(const glm::vec4& DestRect, const glm::vec4& UvRect, GLuint Texture, float Depth, const Color& SpriteColor, GLint Layer = -1, BlendMode Blend = BlendMode::ALPHA);
+
 		GLuint texture;
 		float depth;
+		GLint layer; //which layer of a TextureArray, or -1 for a normal texture
+		BlendMode blendMode;
+
+		//We used to build all four corners (80 bytes) right away in draw. Now the glyph just keeps what it was
+		//given, and the corners get made in end() (createQuadVertices), or on the gpu when we're instancing.
+		glm::vec4 destRect;
+		glm::vec4 uvRect;
+		Color color;
+	};
 
-		Vertex topLeft;
-		Vertex bottomLeft;
-		Vertex topRight;
-		Vertex bottomRight;
+	//With instancing, this is everything the gpu gets for one sprite, 40 bytes instead of 4 Vertex's (80 bytes, or 48 packed).
+	//The vertex shader (colorShadingInstanced.vert) makes the 4 corners itself from gl_VertexID.
+	//There's no depth in here, depth is only used for sorting, which is already done by the time this is written.
+	struct SpriteInstance {
+		glm::vec4 destRect;
+		glm::vec4 uvRect;
+		Color color;
+		float layer; //which layer of a TextureArray, 0 for a normal texture
 	};
 
-	//Each batch is going to store an offset in our vertex buffer object (_vbo)
-	//so that when we call glDrawArrays, we can specify that we want to start at a
+	//Each batch is going to store an offset in our index buffer object (_ibo)
+	//so that when we call glDrawElements, we can specify that we want to start at a
 	//certain point (the offeset). This is so we don't have to have multiple vbo's.
 	class RenderBatch {
 	public:
 		//These need to be named differently from the variables below
 		//We are also initializing them here.
-		RenderBatch(GLuint Offset, GLuint NumVertices, GLuint Texture) : offset(Offset),
-			numVertices(NumVertices), texture(Texture) {}
+		RenderBatch(GLuint Offset, GLuint NumIndices, GLuint Texture, GLenum Target = GL_TEXTURE_2D, BlendMode Blend = BlendMode::ALPHA) : offset(Offset),
+			numIndices(NumIndices), texture(Texture), target(Target), blendMode(Blend) {}
 
-		GLuint offset; //see above
-		GLuint numVertices; //number of vertices we need to draw
+		GLuint offset; //see above, this counts indices, not bytes
+		GLuint numIndices; //number of indices we need to draw, 6 for every quad
 		GLuint texture;
+		GLenum target; //GL_TEXTURE_2D, or GL_TEXTURE_2D_ARRAY for a TextureArray
+		BlendMode blendMode;
 
 	private:
 	};
 
+	/*Collects sprites for a SpriteBatch on another thread. SpriteBatch::draw can only be called from one
+	thread, so update jobs that run at the same time each get their own recorder (SpriteBatch::getRecorder)
+	and call draw on that instead. Nothing is shared between recorders, so there are no locks.
+	Everything a recorder collected gets added to the batch in end(), so the threads have to be done by then.
+
+	The batch keeps the sprites in a set order no matter which thread finished first: everything drawn on
+	the batch itself, then recorder 0, then recorder 1, and so on, each in the order it was drawn. So two
+	sprites that sort the same way come out in the same order every frame.*/
+	class alignas(64) SpriteRecorder { //its own cache line, so threads pushing glyphs don't slow each other down
+	public:
+		SpriteRecorder();
+
+		//Same as SpriteBatch::draw.
+		void draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, float depth, const Color& color, BlendMode blendMode = BlendMode::ALPHA);
+		void draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, GLint layer, float depth, const Color& color, BlendMode blendMode = BlendMode::ALPHA);
+
+		int getNumGlyphs() const { return _glyphs.size(); }
+		int getNumCulled() const { return _numCulled; }
+
+	private:
+		//Only the batch gets to clear us and set the cull rect, so those can't happen while another thread is drawing.
+		friend class SpriteBatch;
+
+		void clear();
+		//True if destRect is completely outside _cullRect. Counts it in _numCulled too.
+		bool isCulled(const glm::vec4& destRect);
+
+		//The actual glyphs live in one contiguous vector. We used to "new" every glyph in draw() and never delete
+		//them, which leaked memory every frame. Now begin() just clears the vector, and clear() keeps the capacity,
+		//so after the first few frames draw() doesn't allocate anything at all.
+		std::vector<Glyph> _glyphs;
+
+		glm::vec4 _cullRect;
+		bool _useCullRect;
+		int _numCulled;
+	};
+
 	class SpriteBatch {
 	public:
 		SpriteBatch();
 		~SpriteBatch();
 
-		void init(); //initialization
+		//initialization. If useTextureArrays is true, every vertex also gets a layer number (attribute 3,
+		//"vertexLayer" in colorShadingArray.vert) so sprites from a TextureArray can be drawn. That costs
+		//a little extra upload every frame, so it's off unless you need it.
+		//If useInstancing is true, each sprite is sent as one SpriteInstance and drawn with glDrawArraysInstanced,
+		//which needs the colorShadingInstanced shaders (or colorShadingArrayInstanced with texture arrays).
+		//That needs openGL 3.3, without it we quietly go back to normal vertices, so check isInstanced()
+		//before picking the shaders.
+		void init(bool useTextureArrays = false, bool useInstancing = false);
+		bool isInstanced() const { return _useInstancing; }
 
 		//Setting the default sort type to texture.
 		void begin(GlyphSortType sortType = GlyphSortType::TEXTURE); //getting ready to draw
@@ -69,29 +145,139 @@ namespace GameEngine {
 		//because this will probably be called many times. We don't want to change these variables though
 		//we can also pass them in with the parameter "const". We don't have to pass the texture in byref
 		//because its just an unsigned int.
-		void draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, float depth, const Color& color); //add all sprites to batch
+		void draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, float depth, const Color& color, BlendMode blendMode = BlendMode::ALPHA); //add all sprites to batch
+
+		//Same thing, but for a sprite in one layer of a TextureArray (texture is TextureArray::getId()).
+		//Every layer of the same array ends up in the same batch, so lots of different images can be one draw call.
+		//This needs init(true) and the colorShadingArray shaders, and shouldn't be mixed with normal
+		//textures between the same begin() and end(), since those need the regular shaders.
+		void draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, GLint layer, float depth, const Color& color, BlendMode blendMode = BlendMode::ALPHA);
+
+		//Sprites that don't touch cullRect (x, y, width, height, in the same units as destRect) get thrown away in
+		//draw, before they cost a sort, vertices or an upload. Usually that's Camera2D::getVisibleRect(), set once
+		//a frame before begin(). It stays until it's set again or cleared. This only looks at destRect, so
+		//anything that moves vertices in the shader needs a bigger rect. Off until it's set.
+		//This goes for every recorder too, so set it before any threads start drawing.
+		void setCullRect(const glm::vec4& cullRect);
+		void clearCullRect();
+
+		//Makes numRecorders recorders for other threads to draw into, see SpriteRecorder. Call this
+		//before begin(), and not while any thread is using one. The recorders are kept between frames.
+		void setNumRecorders(int numRecorders);
+		int getNumRecorders() const { return _recorders.size(); }
+		//Give each thread a different index. The reference stays good until setNumRecorders is called again.
+		SpriteRecorder& getRecorder(int index) { return *_recorders[index]; }
+
+		//render to screen. This sets glBlendFunc itself, but only when the blend mode is different from
+		//the batch before, so mixing blend modes only costs something when they aren't sorted together.
+		void renderBatch();
+
+		//A quad only has 4 unique corners. Instead of sending 6 whole vertices per sprite (topLeft and
+		//bottomRight twice), we send 4 and let an index buffer say which corners make up the two triangles.
+		static const int VERTICES_PER_QUAD = 4;
+		static const int INDICES_PER_QUAD = 6;
+
+		//Calls glBlendFunc for blendMode.
+		static void setBlendMode(BlendMode blendMode);
+
+		//Writes the 4 corners of a glyph to out, in the order the index buffer expects them.
+		//The positions are written relative to origin, see setVertexOrigin.
+		static void createQuadVertices(const Glyph& glyph, const glm::vec2& origin, SpriteVertex* out);
+		static void createInstance(const Glyph& glyph, SpriteInstance& out);
+		//Fills indices with the two triangles for numQuads quads. The pattern is the same for every
+		//quad, so we only ever have to build this when we need room for more sprites.
+		static void createQuadIndices(std::vector<GLuint>& indices, int numQuads);
 
-		void renderBatch(); //render to screen
+		//These are filled in by end(). If init() was never called, end() doesn't touch openGL at all and
+		//writes the vertices into a normal vector instead of the stream buffer, so you can look at exactly
+		//what would have been sent to the gpu without needing a gpu. With init(), getVertices() is empty
+		//because the vertices go straight into the gpu buffer.
+		const std::vector<SpriteVertex>& getVertices() const { return _vertices; }
+
+		//Vertex positions get written relative to this point. With PackedVertex (see Vertex.h) they only
+		//reach 8191 units from it, so set it to the camera's position every frame. With normal vertices it
+		//doesn't matter, but it does keep big worlds from losing float precision far from 0,0.
+		void setVertexOrigin(const glm::vec2& origin) { _vertexOrigin = origin; }
+		const glm::vec2& getVertexOrigin() const { return _vertexOrigin; }
+		//Turns the vertex positions back into world positions: moves them by the origin, and divides by
+		//SpriteVertex::POSITION_SCALE. Multiply the camera matrix by this before giving it to the shader
+		//(P = camera * getVertexTransform()). It's just the identity matrix with instancing, instances aren't packed.
+		glm::mat4 getVertexTransform() const;
+		const std::vector<RenderBatch>& getRenderBatches() const { return _renderBatches; }
+
+		//Stats for the current frame, they get reset in begin(). Sprites that share a texture
+		//should end up in the same batch, so if getNumRenderBatches() is close to getNumGlyphs()
+		//something is breaking up our batches (usually the sort type).
+		int getNumGlyphs() const; //counts the recorders too
+		int getNumRenderBatches() const { return _renderBatches.size(); }
+		int getNumDrawCalls() const { return _numDrawCalls; } //how many glDrawElements renderBatch() has done
+		int getNumBlendChanges() const { return _numBlendChanges; } //how many glBlendFunc renderBatch() has done
+		int getNumCulled() const; //how many draws were outside the cull rect, getNumGlyphs() is the ones kept
 
 	private:
-		void createRenderBatches();
+		//firstQuad is where in the vertex buffer (counted in quads) vertices starts, so the batch offsets
+		//can point at the right spot in the index buffer.
+		//layers is where to write each vertex's layer, or nullptr if we aren't using texture arrays.
+		//With instancing, vertices and layers are nullptr and everything goes in instances instead.
+		void createRenderBatches(SpriteVertex* vertices, GLushort* layers, SpriteInstance* instances, GLuint firstQuad);
 		void createVertexArray();
+		//Points the instance attributes at firstInstance in the stream buffer. Only needed per batch when
+		//the driver can't start an instanced draw partway through the buffer (no ARB_base_instance).
+		void setInstancePointers(GLuint firstInstance);
+		//How many bytes one sprite takes in _vertexStream.
+		GLsizeiptr getBytesPerQuad() const { return _useInstancing ? sizeof(SpriteInstance) : VERTICES_PER_QUAD * sizeof(SpriteVertex); }
+		void createIndexBuffer(int numQuads);
 		void sortGlyphs();
 
-		static bool compareFrontToBack(Glyph* a, Glyph* b);
-		static bool compareBackToFront(Glyph* a, Glyph* b);
-		static bool compareTexture(Glyph* a, Glyph* b);
+		//The part of a glyph's 64 bit sort key that decides the order for the sort type, see sortGlyphs.
+		static uint32_t createSortKey(const Glyph& glyph, GlyphSortType sortType);
+		//Sorts keys from smallest to biggest, using scratch as the second buffer.
+		static void radixSortKeys(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch);
 
-		GLuint _vbo;
+		//How many quads fit in one section of the stream buffer before we make it bigger.
+		static const int INITIAL_STREAM_QUADS = 1024;
+
+		//The vertices (or instances) get written right into this every frame, see StreamBuffer.h.
+		StreamBuffer _vertexStream;
+		int _streamQuads; //how many quads fit in one section of _vertexStream
+		//The layer for every vertex, only used with texture arrays. It's a separate buffer so that normal
+		//sprites don't have to pay for it. It always moves to its next section together with _vertexStream,
+		//so vertex number i and layer number i are always in the same spot.
+		StreamBuffer _layerStream;
+		bool _useTextureArrays;
+		bool _useInstancing; //_vertexStream holds SpriteInstances instead of Vertex's, and there's no _ibo
+		bool _useBaseInstance;
 		GLuint _vao;
+		GLuint _ibo;
+		int _indexBufferQuads; //how many quads _ibo has indices for
 
 		GlyphSortType _sortType;
 		
-		//Because we are going to have to sort this vector frequently because we want to keep like textures
+		//Whatever draw() is called with on the batch itself.
+		SpriteRecorder _recorder;
+		//One per thread, see setNumRecorders. They're separate allocations so a thread's
+		//glyphs never share a cache line with another thread's.
+		std::vector<std::unique_ptr<SpriteRecorder>> _recorders;
+
+		//Because we are going to have to sort frequently because we want to keep like textures
 		//together, so that we can batch them together when we draw them with SpriteBatch, we want to sort 
-		//pointers* instead of all of the data that would be stored in a glyph struct.
-		std::vector<Glyph*> _glyphs;
+		//pointers* instead of all of the data that would be stored in a glyph struct. These point into the
+		//recorders' glyphs, so they are only filled in at end(), after those are done growing.
+		//Merging the recorders is just adding their pointers one recorder after another, nothing gets copied.
+		std::vector<Glyph*> _glyphPointers;
+
+		//These are only kept around so sorting doesn't have to allocate every frame.
+		std::vector<uint64_t> _sortKeys;
+		std::vector<uint64_t> _sortScratch;
+		std::vector<Glyph*> _sortedPointers;
+
 		std::vector<RenderBatch> _renderBatches;
+		int _numDrawCalls;
+		int _numBlendChanges;
+
+		//Only used when there is no gpu, see getVertices().
+		std::vector<SpriteVertex> _vertices;
+		glm::vec2 _vertexOrigin;
 
 	};
 
@@ -0,0 +1,118 @@
+#include "StaticSpriteBatch.h"
+
+namespace GameEngine {
+
+	StaticSpriteBatch::StaticSpriteBatch() :
+		_vao(0),
+		_vbo(0),
+		_ibo(0),
+		_numGlyphs(0),
+		_numDrawCalls(0),
+		_numBuilds(0),
+		_isValid(false)
+	{
+	}
+
+
+	StaticSpriteBatch::~StaticSpriteBatch()
+	{
+	}
+
+	void StaticSpriteBatch::init() {
+		glGenVertexArrays(1, &_vao);
+		glGenBuffers(1, &_vbo);
+		glGenBuffers(1, &_ibo);
+
+		//Same layout as SpriteBatch, so the same shaders work. The buffers are empty until end().
+		glBindVertexArray(_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+
+		setVertexAttributes<SpriteVertex>();
+
+		glBindVertexArray(0);
+	}
+
+	void StaticSpriteBatch::destroy() {
+		if (_vao != 0) {
+			glDeleteVertexArrays(1, &_vao);
+			glDeleteBuffers(1, &_vbo);
+			glDeleteBuffers(1, &_ibo);
+			_vao = 0;
+			_vbo = 0;
+			_ibo = 0;
+		}
+		_renderBatches.clear();
+		_numGlyphs = 0;
+		_isValid = false;
+	}
+
+	void StaticSpriteBatch::begin(GlyphSortType sortType /* GlyphSortType::TEXTURE */) {
+		invalidate();
+		_builder.begin(sortType);
+	}
+
+	void StaticSpriteBatch::draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, float depth, const Color& color, BlendMode blendMode) {
+		_builder.draw(destRect, uvRect, texture, depth, color, blendMode);
+	}
+
+	void StaticSpriteBatch::end() {
+		//The builder has no gpu buffer, so this sorts and writes every vertex into getVertices(),
+		//with batch offsets that start at 0. That's exactly what our buffer is going to look like.
+		_builder.end();
+
+		const std::vector<SpriteVertex>& vertices = _builder.getVertices();
+		_numGlyphs = _builder.getNumGlyphs();
+		_renderBatches = _builder.getRenderBatches();
+
+		std::vector<GLuint> indices;
+		SpriteBatch::createQuadIndices(indices, _numGlyphs);
+
+		//GL_STATIC_DRAW tells the driver we're going to draw this a lot without changing it,
+		//so it can keep it in video memory. glBufferData makes a new buffer every time, so if
+		//the level got bigger or smaller since last time, that's fine too.
+		glBindVertexArray(_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(SpriteVertex), vertices.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+		glBindVertexArray(0);
+
+		//Everything lives on the gpu now, so the builder can let go of its glyphs. Its vectors keep
+		//their capacity, which makes the next rebuild cheaper.
+		_builder.begin();
+
+		_numBuilds++;
+		_isValid = true;
+	}
+
+	void StaticSpriteBatch::renderBatch() {
+		_numDrawCalls = 0;
+		if (!_isValid || _renderBatches.empty()) {
+			return;
+		}
+
+		glBindVertexArray(_vao);
+
+		//Same as SpriteBatch::renderBatch, somebody else could have changed the blend function.
+		glEnable(GL_BLEND);
+		for (size_t i = 0; i < _renderBatches.size(); i++) {
+			if (i == 0 || _renderBatches[i].blendMode != _renderBatches[i - 1].blendMode) {
+				SpriteBatch::setBlendMode(_renderBatches[i].blendMode);
+			}
+			glBindTexture(_renderBatches[i].target, _renderBatches[i].texture);
+
+			//The last parameter is where to start in the index buffer, and it wants it in bytes.
+			glDrawElements(GL_TRIANGLES, _renderBatches[i].numIndices, GL_UNSIGNED_INT,
+				(void*)(_renderBatches[i].offset * sizeof(GLuint)));
+			_numDrawCalls++;
+		}
+
+		glBindVertexArray(0);
+	}
+
+	void StaticSpriteBatch::invalidate() {
+		_isValid = false;
+	}
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "SpriteBatch.h"
+
+namespace GameEngine {
+
+	/*A SpriteBatch for sprites that don't move, like the ground tiles and the background of a level.
+	SpriteBatch sorts, builds and uploads every sprite again every frame, which is a waste when nothing
+	changed. This one does all of that once, into a GL_STATIC_DRAW buffer that stays on the gpu, and
+	after that renderBatch just does the same draw calls again.
+
+	Use it the same way as a SpriteBatch: begin, draw, end, and then renderBatch every frame. When
+	something in it changes, call invalidate, and draw everything again between begin and end.
+	Nothing gets rebuilt on its own, it doesn't know when its sprites change.
+
+	It uses normal vertices (SpriteVertex), so draw it with the colorShading shaders, not the instanced ones.
+	It remembers texture ids, not handles, so keep a reference (ResourceManager::loadTexture) to every
+	texture in it, otherwise the texture cache could evict one while we're still drawing it.*/
+
+	class StaticSpriteBatch
+	{
+	public:
+		StaticSpriteBatch();
+		~StaticSpriteBatch();
+
+		void init();
+		void destroy();
+
+		//Throws away whatever was built before.
+		void begin(GlyphSortType sortType = GlyphSortType::TEXTURE);
+		//Same as SpriteBatch::draw. There's no TextureArray version.
+		void draw(const glm::vec4& destRect, const glm::vec4& uvRect, GLuint texture, float depth, const Color& color, BlendMode blendMode = BlendMode::ALPHA);
+		//Sorts, builds the vertices and uploads them. This is the slow part, it should only happen when something changed.
+		void end();
+
+		//Draws whatever the last end() built. Costs the same as SpriteBatch::renderBatch, minus the upload.
+		void renderBatch();
+
+		//Same as SpriteBatch::setVertexOrigin, it counts from the next end(). With PackedVertex a level
+		//can only be 16382 units across, so put this in the middle of it, or split it into more batches.
+		void setVertexOrigin(const glm::vec2& origin) { _builder.setVertexOrigin(origin); }
+		glm::mat4 getVertexTransform() const { return _builder.getVertexTransform(); }
+
+		//Call this when the sprites change. Until begin and end happen again, renderBatch doesn't draw anything.
+		void invalidate();
+		//False before the first end(), and after invalidate.
+		bool isValid() const { return _isValid; }
+
+		int getNumGlyphs() const { return _numGlyphs; }
+		int getNumRenderBatches() const { return _renderBatches.size(); }
+		int getNumDrawCalls() const { return _numDrawCalls; } //how many glDrawElements the last renderBatch() did
+		int getNumBuilds() const { return _numBuilds; } //how many times end() has uploaded, to catch something rebuilding every frame
+		//How much video memory the vertex and index buffers take.
+		size_t getMemorySize() const { return _numGlyphs * (SpriteBatch::VERTICES_PER_QUAD * sizeof(SpriteVertex) + SpriteBatch::INDICES_PER_QUAD * sizeof(GLuint)); }
+
+	private:
+		//Never gets init() called, so its end() only sorts and builds the vertices and
+		//batches on the cpu (see SpriteBatch::getVertices). We do the uploading.
+		SpriteBatch _builder;
+
+		std::vector<RenderBatch> _renderBatches;
+		GLuint _vao;
+		GLuint _vbo;
+		GLuint _ibo;
+		int _numGlyphs;
+		int _numDrawCalls;
+		int _numBuilds;
+		bool _isValid;
+	};
+
+}
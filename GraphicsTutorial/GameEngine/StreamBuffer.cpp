@@ -0,0 +1,166 @@
+#include "StreamBuffer.h"
+#include "Errors.h"
+
+namespace GameEngine {
+
+	const int StreamBuffer::NUM_SECTIONS;
+
+	StreamBuffer::StreamBuffer() :
+		_bufferId(0),
+		_sectionSize(0),
+		_section(0),
+		_mode(StreamBufferMode::ORPHAN),
+		_persistentData(nullptr)
+	{
+		for (int i = 0; i < NUM_SECTIONS; i++) {
+			_fences[i] = 0;
+		}
+	}
+
+
+	StreamBuffer::~StreamBuffer()
+	{
+	}
+
+	void StreamBuffer::init(GLsizeiptr sectionSize) {
+		//We pick the best way to stream that the driver has. glBufferStorage is core in 4.4,
+		//fences are core in 3.2, and the glew variables tell us if the extensions are there.
+		if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+			_mode = StreamBufferMode::PERSISTENT;
+		} else if (GLEW_VERSION_3_2 || GLEW_ARB_sync) {
+			_mode = StreamBufferMode::UNSYNCHRONIZED;
+		} else {
+			_mode = StreamBufferMode::ORPHAN;
+		}
+
+		_sectionSize = sectionSize;
+		_section = 0;
+		createBuffer();
+	}
+
+	void StreamBuffer::destroy() {
+		if (_bufferId == 0) {
+			return;
+		}
+
+		//Make sure the gpu is done with everything before the memory goes away.
+		for (int i = 0; i < NUM_SECTIONS; i++) {
+			waitForFence(i);
+		}
+
+		if (_persistentData != nullptr) {
+			glBindBuffer(GL_ARRAY_BUFFER, _bufferId);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			_persistentData = nullptr;
+		}
+
+		glDeleteBuffers(1, &_bufferId);
+		_bufferId = 0;
+	}
+
+	void StreamBuffer::resize(GLsizeiptr sectionSize) {
+		//A buffer made with glBufferStorage can never change size, so we always just make a new one.
+		destroy();
+		_sectionSize = sectionSize;
+		_section = 0;
+		createBuffer();
+	}
+
+	void* StreamBuffer::map(GLsizeiptr size) {
+		if (size > _sectionSize) {
+			fatalError("StreamBuffer::map asked for more than one section!");
+		}
+
+		//In ORPHAN mode the driver hands us new memory every time, so there's no point moving around.
+		if (_mode != StreamBufferMode::ORPHAN) {
+			_section = (_section + 1) % NUM_SECTIONS;
+			waitForFence(_section);
+		}
+
+		switch (_mode) {
+			case StreamBufferMode::PERSISTENT:
+				//It's always mapped, so this is just pointer math.
+				return _persistentData + getSectionOffset();
+			case StreamBufferMode::UNSYNCHRONIZED:
+				glBindBuffer(GL_ARRAY_BUFFER, _bufferId);
+				//UNSYNCHRONIZED means openGL won't stall waiting for the gpu, the fence already did that for us.
+				return glMapBufferRange(GL_ARRAY_BUFFER, getSectionOffset(), size,
+					GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+			case StreamBufferMode::ORPHAN:
+			default:
+				glBindBuffer(GL_ARRAY_BUFFER, _bufferId);
+				return glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		}
+	}
+
+	void StreamBuffer::unmap() {
+		//The persistent mapping is coherent, so whatever we wrote is already visible to the gpu.
+		if (_mode == StreamBufferMode::PERSISTENT) {
+			return;
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, _bufferId);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void StreamBuffer::fence() {
+		if (_mode == StreamBufferMode::ORPHAN) {
+			return;
+		}
+		if (_fences[_section] != 0) {
+			glDeleteSync(_fences[_section]);
+		}
+		//This gets signaled once the gpu has finished every command we've given it so far,
+		//which includes the draw calls that read this section.
+		_fences[_section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	void StreamBuffer::createBuffer() {
+		GLsizeiptr totalSize = _sectionSize * NUM_SECTIONS;
+
+		glGenBuffers(1, &_bufferId);
+		glBindBuffer(GL_ARRAY_BUFFER, _bufferId);
+
+		switch (_mode) {
+			case StreamBufferMode::PERSISTENT: {
+				//COHERENT means we don't have to flush anything, the gpu sees our writes on its own.
+				GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+				glBufferStorage(GL_ARRAY_BUFFER, totalSize, nullptr, flags);
+				_persistentData = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, totalSize, flags);
+				if (_persistentData == nullptr) {
+					fatalError("Failed to persistently map the stream buffer!");
+				}
+				break;
+			}
+			case StreamBufferMode::UNSYNCHRONIZED:
+				glBufferData(GL_ARRAY_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+				break;
+			case StreamBufferMode::ORPHAN:
+				//Only one section is ever used here.
+				glBufferData(GL_ARRAY_BUFFER, _sectionSize, nullptr, GL_STREAM_DRAW);
+				break;
+		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	void StreamBuffer::waitForFence(int section) {
+		if (_fences[section] == 0) {
+			return;
+		}
+
+		//Keep waiting (and flushing, so the fence actually gets to the gpu) until it's signaled.
+		//The timeout is in nanoseconds, so this is one millisecond at a time.
+		while (true) {
+			GLenum result = glClientWaitSync(_fences[section], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+				break;
+			}
+		}
+
+		glDeleteSync(_fences[section]);
+		_fences[section] = 0;
+	}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <GL/glew.h>
+
+namespace GameEngine {
+
+	/*This is a vertex buffer that we write into directly every frame, instead of filling
+	a std::vector and then copying it over with glBufferSubData. The buffer is split into
+	three sections (triple buffering). Each frame we write into the next section while the
+	gpu is still free to read the sections from the last couple of frames, and a fence
+	tells us when the gpu is actually done with a section so we never write over data
+	it is still drawing.
+
+	How we get a pointer to write to depends on what the driver supports:
+	PERSISTENT - ARB_buffer_storage, the buffer stays mapped forever, we just write to it.
+	UNSYNCHRONIZED - ARB_sync, we map only the section we need each frame and tell openGL
+	not to wait, because our fences already do the waiting for it.
+	ORPHAN - neither of those, we map with GL_MAP_INVALIDATE_BUFFER_BIT so the driver gives
+	us fresh memory, which is the same idea as the old glBufferData(nullptr) orphaning.*/
+
+	enum class StreamBufferMode {
+		PERSISTENT,
+		UNSYNCHRONIZED,
+		ORPHAN
+	};
+
+	class StreamBuffer
+	{
+	public:
+		StreamBuffer();
+		~StreamBuffer();
+
+		static const int NUM_SECTIONS = 3;
+
+		//sectionSize is how many bytes we can write each frame.
+		void init(GLsizeiptr sectionSize);
+		void destroy();
+
+		//Makes each section at least sectionSize bytes. This has to make a brand new buffer,
+		//so anything that points at getBufferId() (like a vertex array) needs to be set up again.
+		void resize(GLsizeiptr sectionSize);
+
+		//Moves on to the next section, waits for the gpu to be done with it, and returns a
+		//pointer that size bytes can be written to. size can't be bigger than getSectionSize().
+		void* map(GLsizeiptr size);
+		//Call this after writing and before drawing.
+		void unmap();
+		//Call this right after the draw calls that read the current section have been issued.
+		void fence();
+
+		GLuint getBufferId() const { return _bufferId; }
+		GLsizeiptr getSectionSize() const { return _sectionSize; }
+		//Where the current section starts in the buffer, in bytes.
+		GLsizeiptr getSectionOffset() const { return _section * _sectionSize; }
+		StreamBufferMode getMode() const { return _mode; }
+
+	private:
+		void createBuffer();
+		void waitForFence(int section);
+
+		GLuint _bufferId;
+		GLsizeiptr _sectionSize;
+		int _section;
+		StreamBufferMode _mode;
+
+		//Only used in PERSISTENT mode, this is the start of the whole mapped buffer.
+		unsigned char* _persistentData;
+		GLsync _fences[NUM_SECTIONS];
+	};
+
+}
@@ -0,0 +1,78 @@
+#include "TextureArray.h"
+#include "picoPNG.h"
+#include "MappedFile.h"
+#include "Errors.h"
+
+namespace GameEngine {
+
+	TextureArray::TextureArray() :
+		_id(0),
+		_width(0),
+		_height(0)
+	{
+	}
+
+
+	TextureArray::~TextureArray()
+	{
+	}
+
+	void TextureArray::init(const std::vector<std::string>& filePaths) {
+		if (filePaths.empty()) {
+			fatalError("TextureArray needs at least one texture!");
+		}
+
+		MappedFile in;
+		std::vector<unsigned char> out;
+		unsigned long width, height;
+
+		glGenTextures(1, &_id);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, _id);
+
+		for (size_t layer = 0; layer < filePaths.size(); layer++) {
+			if (in.open(filePaths[layer]) == false) {
+				fatalError("Failed to load PNG file to buffer!");
+			}
+
+			int errorCode = decodePNG(out, width, height, in.data(), (size_t)in.size());
+			if (errorCode != 0) {
+				fatalError("decodePNG failed with error: " + std::to_string(errorCode));
+			}
+
+			if (layer == 0) {
+				_width = width;
+				_height = height;
+				//We need to know the size before we can make room for all the layers, so the first image decides it.
+				//Passing nullptr just makes the space, we fill in each layer with glTexSubImage3D.
+				glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, _width, _height, filePaths.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			} else if ((int)width != _width || (int)height != _height) {
+				fatalError("Texture " + filePaths[layer] + " isn't the same size as the rest of its TextureArray!");
+			}
+
+			//The z offset is the layer, and we're only uploading one layer deep.
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, _width, _height, 1, GL_RGBA, GL_UNSIGNED_BYTE, &(out[0]));
+
+			_layers[filePaths[layer]] = (int)layer;
+		}
+
+		//Same settings ImageLoader::loadPNG uses for regular textures.
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+		//Each layer gets its own mipmaps, they never get mixed with the other layers.
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	int TextureArray::getLayer(const std::string& filePath) const {
+		auto it = _layers.find(filePath);
+		if (it == _layers.end()) {
+			return -1;
+		}
+		return it->second;
+	}
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace GameEngine {
+
+	/*A texture array is one openGL texture (GL_TEXTURE_2D_ARRAY) that has a bunch of
+	images stacked on top of each other in layers. Since it's only one texture, SpriteBatch
+	can draw sprites from every layer with a single bind and a single draw call, instead of
+	a new draw call every time the texture changes. The catch is every layer has to be the
+	same size, so this works best for things like tiles that are all the same size.
+
+	To draw from it, use the SpriteBatch::draw that takes a layer, init the SpriteBatch with
+	texture arrays turned on, and use the colorShadingArray shaders.*/
+
+	class TextureArray
+	{
+	public:
+		TextureArray();
+		~TextureArray();
+
+		//Loads every png into its own layer, in the order they are given.
+		//They all have to be the same width and height as the first one.
+		void init(const std::vector<std::string>& filePaths);
+
+		//Returns the layer that filePath was loaded into, or -1 if it isn't in this array.
+		int getLayer(const std::string& filePath) const;
+
+		GLuint getId() const { return _id; }
+		int getWidth() const { return _width; }
+		int getHeight() const { return _height; }
+		int getNumLayers() const { return _layers.size(); }
+
+	private:
+		GLuint _id;
+		int _width;
+		int _height;
+		std::map<std::string, int> _layers;
+	};
+
+}
@@ -0,0 +1,126 @@
+#include "TextureAtlas.h"
+#include "ResourceManager.h"
+#include "MappedFile.h"
+#include "Errors.h"
+
+#include <cctype>
+#include <climits>
+#include <cstdlib>
+#include <vector>
+
+namespace GameEngine {
+
+	TextureAtlas::TextureAtlas() :
+		_texture()
+	{
+	}
+
+
+	TextureAtlas::~TextureAtlas()
+	{
+	}
+
+	void TextureAtlas::init(const std::string& xmlPath) {
+		MappedFile file;
+		if (file.open(xmlPath) == false) {
+			fatalError("Failed to load texture atlas " + xmlPath);
+		}
+		std::string xml((const char*)file.data(), (size_t)file.size());
+
+		//We don't need a whole xml library for this, every tag we care about is
+		//just <Name attribute="value" .../>, so we find each tag and read its attributes.
+		size_t atlasStart = xml.find("<TextureAtlas");
+		if (atlasStart == std::string::npos) {
+			fatalError(xmlPath + " is not a texture atlas!");
+		}
+		std::string atlasTag = xml.substr(atlasStart, xml.find('>', atlasStart) - atlasStart);
+		std::string imagePath = getAttribute(atlasTag, "imagePath");
+		if (imagePath.empty()) {
+			fatalError(xmlPath + " has no imagePath in its TextureAtlas tag!");
+		}
+
+		//The image path is relative to the xml, so we stick the xml's folder on the front.
+		size_t lastSlash = xmlPath.find_last_of("/\\");
+		if (lastSlash != std::string::npos) {
+			imagePath = xmlPath.substr(0, lastSlash + 1) + imagePath;
+		}
+
+		//The whole sheet is only one texture, that's the point.
+		_texture = ResourceManager::getTexture(imagePath);
+		float sheetWidth = (float)_texture.width;
+		float sheetHeight = (float)_texture.height;
+
+		size_t tagStart = xml.find("<SubTexture", atlasStart);
+		while (tagStart != std::string::npos) {
+			size_t tagEnd = xml.find('>', tagStart);
+			std::string tag = xml.substr(tagStart, tagEnd - tagStart);
+
+			std::string name = getAttribute(tag, "name");
+			if (name.empty()) {
+				fatalError(xmlPath + " has a SubTexture with no name!");
+			}
+
+			int x = getIntAttribute(tag, "x", xmlPath, name);
+			int y = getIntAttribute(tag, "y", xmlPath, name);
+
+			AtlasRegion region;
+			region.texture = _texture.id;
+			region.width = getIntAttribute(tag, "width", xmlPath, name);
+			region.height = getIntAttribute(tag, "height", xmlPath, name);
+
+			//The xml counts y from the top of the image in pixels, but our uvs go from 0 to 1 with
+			//v = 0 at the bottom (the shader flips v), so the bottom of the region is 1 - (y + height).
+			region.uvRect.x = x / sheetWidth;
+			region.uvRect.y = 1.0f - (y + region.height) / sheetHeight;
+			region.uvRect.z = region.width / sheetWidth;
+			region.uvRect.w = region.height / sheetHeight;
+
+			_regions[name] = region;
+
+			tagStart = xml.find("<SubTexture", tagEnd);
+		}
+	}
+
+	bool TextureAtlas::hasRegion(const std::string& name) const {
+		return _regions.find(name) != _regions.end();
+	}
+
+	const AtlasRegion& TextureAtlas::getRegion(const std::string& name) const {
+		auto it = _regions.find(name);
+		if (it == _regions.end()) {
+			fatalError("Texture atlas has no region named " + name);
+		}
+		return it->second;
+	}
+
+	std::string TextureAtlas::getAttribute(const std::string& tag, const std::string& name) {
+		//Checking the character in front makes sure we don't find "x" inside of something like "maxX".
+		//It can be a space, a tab or a new line, some exporters line the attributes up with tabs.
+		std::string search = name + "=\"";
+		size_t start = tag.find(search);
+		while (start != std::string::npos && (start == 0 || !isspace((unsigned char)tag[start - 1]))) {
+			start = tag.find(search, start + 1);
+		}
+		if (start == std::string::npos) {
+			return "";
+		}
+		start += search.size();
+		size_t end = tag.find('"', start);
+		if (end == std::string::npos) {
+			return "";
+		}
+		return tag.substr(start, end - start);
+	}
+
+	int TextureAtlas::getIntAttribute(const std::string& tag, const std::string& name, const std::string& xmlPath, const std::string& regionName) {
+		std::string value = getAttribute(tag, name);
+		//strtol tells us where it stopped, so "12px" or "" don't count as numbers.
+		char* end = nullptr;
+		long number = strtol(value.c_str(), &end, 10);
+		if (value.empty() || *end != '\0' || number < INT_MIN || number > INT_MAX) {
+			fatalError("SubTexture " + regionName + " in " + xmlPath + " has a missing or bad " + name + " attribute!");
+		}
+		return (int)number;
+	}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "GLTexture.h"
+
+#include <glm/glm.hpp>
+
+#include <map>
+#include <string>
+
+namespace GameEngine {
+
+	//One image inside of an atlas. texture and uvRect can be handed straight to SpriteBatch::draw.
+	struct AtlasRegion {
+		GLuint texture;
+		glm::vec4 uvRect; //x and y are the bottom left corner, z and w are the width and height, all from 0 to 1
+		int width; //size in pixels, handy for making a destRect that isn't stretched
+		int height;
+	};
+
+	/*A texture atlas (or sprite sheet) is a bunch of images packed into one big image,
+	with an xml file that says where each one is. Since everything is in one texture,
+	SpriteBatch can draw all of them in one batch without ever switching textures.
+
+	The xml looks like this (it's the format our sprites.xml comes in):
+	<TextureAtlas imagePath="sprites.png">
+		<SubTexture name="Coin.png" x="0" y="0" width="64" height="64"/>
+	</TextureAtlas>
+	imagePath is relative to the folder the xml file is in.*/
+
+	class TextureAtlas
+	{
+	public:
+		TextureAtlas();
+		~TextureAtlas();
+
+		//Reads the xml and loads the sheet it points to through the ResourceManager.
+		void init(const std::string& xmlPath);
+
+		bool hasRegion(const std::string& name) const;
+		//name is the SubTexture name from the xml, like "Coin.png".
+		const AtlasRegion& getRegion(const std::string& name) const;
+
+		GLTexture getTexture() const { return _texture; }
+		int getNumRegions() const { return _regions.size(); }
+
+	private:
+		//Finds name="value" inside of tag and returns value, or "" if it isn't there.
+		static std::string getAttribute(const std::string& tag, const std::string& name);
+		//Same thing for the numbers in a SubTexture, but it calls fatalError (with the file and the region)
+		//when the attribute is missing or isn't a number, instead of std::stoi throwing.
+		static int getIntAttribute(const std::string& tag, const std::string& name, const std::string& xmlPath, const std::string& regionName);
+
+		GLTexture _texture;
+		std::map<std::string, AtlasRegion> _regions;
+	};
+
+}
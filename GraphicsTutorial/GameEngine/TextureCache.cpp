@@ -1,39 +1,312 @@
 #include "TextureCache.h"
 #include "ImageLoader.h"
+#include "Errors.h"
+#include "IOManger.h"
+#include "AssetArchive.h"
+#include "CompressedImageLoader.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
 namespace GameEngine {
-	TextureCache::TextureCache()
+	TextureCache::TextureCache() :
+		_numLoading(0),
+		_memoryBudget(0),
+		_memoryUsed(0),
+		_memoryHighWater(0),
+		_numEvicted(0),
+		_frame(0),
+		_placeholder()
 	{
 	}
 
 
 	TextureCache::~TextureCache()
 	{
+		//The workers write into _decoded, so they have to be stopped before it goes away.
+		_threadPool.destroy();
 	}
 
 
-	GLTexture TextureCache::getTexture(std::string texturePath) {
+	TextureHandle TextureCache::loadTexture(std::string_view texturePath, const TextureOptions& options) {
+		TextureHandle handle = findTexture(texturePath, options);
+		_textures[handle].numReferences++;
+		return handle;
+	}
+
+	TextureHandle TextureCache::findTexture(std::string_view texturePath, const TextureOptions& options) {
 
 		//The iterator declaration for this sucks. map(key,value)iterator variable
-		//std::map<std::string, GLTexture>::iterator mit = _textureMap.find(texturePath)
+		//std::unordered_map<std::string_view, TextureHandle>::iterator mit = _textureMap.find(texturePath)
 		//auto can discern something like this because there's only one thing it could be.
 		auto mit = _textureMap.find(texturePath);
 
 		//check if its not in the map
+		TextureHandle handle;
 		if (mit == _textureMap.end()) {
-			GLTexture newTexture = ImageLoader::loadPNG(texturePath);
-
-			//a pair is two values that are combined together, like k,v.
-			//std::pair<std::string, GLTexture> newPair(texturePath, newTexture);
-			//_textureMap.insert(newPair)
+			handle = addTexture(texturePath, options);
+		} else {
+			handle = mit->second;
+		}
 
-			_textureMap.insert(make_pair(texturePath, newTexture));
+		//Somebody asked for it in the background already, but we need it now.
+		while (_textures[handle].loading) {
+			if (!uploadFinished()) {
+				waitForDecoded();
+			}
+		}
 
-			return newTexture;
+		//Either it's brand new or it was evicted, so load it right here.
+		if (!_textures[handle].loaded) {
+			setLoaded(handle, ImageLoader::loadTexture(_paths[handle], _textures[handle].options));
 		}
 
+		_textures[handle].lastUsedFrame = _frame;
 		//if its found, we want to return the value (where we store the texture)
-		return mit->second;
+		return handle;
+	}
+
+	TextureHandle TextureCache::loadTextureAsync(std::string_view texturePath, const TextureOptions& options) {
+		TextureHandle handle;
+		auto mit = _textureMap.find(texturePath);
+		if (mit == _textureMap.end()) {
+			handle = addTexture(texturePath, options);
+		} else {
+			handle = mit->second;
+		}
+
+		if (!_textures[handle].loaded && !_textures[handle].loading) {
+			startLoading(handle);
+		}
+		_textures[handle].numReferences++;
+		_textures[handle].lastUsedFrame = _frame;
+		return handle;
+	}
+
+	std::vector<TextureHandle> TextureCache::loadDirectoryAsync(const std::string& folderPath, const TextureOptions& options) {
+		std::vector<TextureHandle> handles;
+		//Shipping builds might only have the folder inside of an archive.
+		for (auto& filePath : IOManger::getArchivedFiles(folderPath)) {
+			if (isTextureFile(filePath)) {
+				handles.push_back(loadTextureAsync(filePath, options));
+			}
+		}
+		if (std::filesystem::is_directory(folderPath)) {
+			for (auto& entry : std::filesystem::recursive_directory_iterator(folderPath)) {
+				//generic_string gives forward slashes, the same as the paths we type in by hand.
+				std::string filePath = entry.path().generic_string();
+				if (!entry.is_regular_file() || !isTextureFile(filePath)) {
+					continue;
+				}
+				//A dev build can have the folder on disk and in an archive. We already loaded the
+				//archived copy above, and loading it again would give the caller two references.
+				const unsigned char* archivedData;
+				uint64_t archivedSize;
+				if (IOManger::findInArchives(filePath, archivedData, archivedSize)) {
+					continue;
+				}
+				handles.push_back(loadTextureAsync(filePath, options));
+			}
+		}
+		return handles;
+	}
+
+	void TextureCache::releaseTexture(TextureHandle handle) {
+		if (_textures[handle].numReferences > 0) {
+			_textures[handle].numReferences--;
+		}
+		evictToBudget();
+	}
+
+	void TextureCache::setMemoryBudget(size_t bytes) {
+		_memoryBudget = bytes;
+		evictToBudget();
+	}
+
+	void TextureCache::printMemoryReport() const {
+		//Biggest first, those are the ones worth compressing or shrinking.
+		std::vector<TextureHandle> handles;
+		for (TextureHandle handle = 0; handle < (TextureHandle)_textures.size(); handle++) {
+			if (_textures[handle].loaded) {
+				handles.push_back(handle);
+			}
+		}
+		std::sort(handles.begin(), handles.end(), [this](TextureHandle a, TextureHandle b) {
+			return _textures[a].texture.memorySize > _textures[b].texture.memorySize;
+		});
+
+		const double MB = 1024.0 * 1024.0;
+		printf("Texture memory: %.2f MB in %d textures, highest %.2f MB, budget %.2f MB (0 is none), %d evicted\n",
+			_memoryUsed / MB, (int)handles.size(), _memoryHighWater / MB, _memoryBudget / MB, _numEvicted);
+		for (TextureHandle handle : handles) {
+			const GLTexture& texture = _textures[handle].texture;
+			//Bytes per pixel shows how it's stored: about 5.3 for RGBA with mipmaps, 0.5 to 1.3 for compressed.
+			printf("%10.1f KB  %5dx%-5d %5.2f bytes/pixel  %3d refs  %s\n", texture.memorySize / 1024.0, texture.width, texture.height,
+				(double)texture.memorySize / ((double)texture.width * texture.height), _textures[handle].numReferences, _paths[handle].c_str());
+		}
+	}
+
+	const GLTexture& TextureCache::getTexture(TextureHandle handle) const {
+		//Before it's loaded this is a copy of the placeholder, so either way it's good to draw with.
+		_textures[handle].lastUsedFrame = _frame;
+		return _textures[handle].texture;
+	}
+
+	void TextureCache::update(float maxMilliseconds) {
+		_frame++;
+		if (_numLoading == 0) {
+			return;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		while (uploadFinished()) {
+			std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			if (elapsed.count() >= maxMilliseconds) {
+				break;
+			}
+		}
+	}
+
+	void TextureCache::finishLoading() {
+		while (_numLoading > 0) {
+			if (!uploadFinished()) {
+				waitForDecoded();
+			}
+		}
+	}
+
+	TextureHandle TextureCache::addTexture(std::string_view texturePath, const TextureOptions& options) {
+		TextureHandle handle = _textures.size();
+		_paths.emplace_back(texturePath);
+
+		//a pair is two values that are combined together, like k,v.
+		//The key has to be the view of our copy, not texturePath, which belongs to whoever called us.
+		_textureMap.insert(std::make_pair(std::string_view(_paths.back()), handle));
+
+		CacheEntry entry = {};
+		entry.texture = _placeholder;
+		entry.options = options;
+		_textures.push_back(entry);
+		return handle;
+	}
+
+	void TextureCache::startLoading(TextureHandle handle) {
+		initAsync();
+
+		_textures[handle].texture = _placeholder;
+		_textures[handle].loading = true;
+		_numLoading++;
+
+		//The job gets its own copy of the path and options, _paths is only safe to touch from the main thread.
+		_threadPool.addJob([this, handle, path = _paths[handle], options = _textures[handle].options]() {
+			DecodedTexture decoded;
+			decoded.handle = handle;
+			if (ImageLoader::decodeImage(path, decoded.image, decoded.error, options) == false) {
+				decoded.error = path + ": " + decoded.error;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(_decodedMutex);
+				_decoded.push_back(std::move(decoded));
+			}
+			_decodedAdded.notify_one();
+		});
+	}
+
+	void TextureCache::setLoaded(TextureHandle handle, const GLTexture& texture) {
+		CacheEntry& entry = _textures[handle];
+		entry.texture = texture;
+		entry.loaded = true;
+		entry.loading = false;
+		//Counts as used, or going over the budget right here would throw it straight back out.
+		entry.lastUsedFrame = _frame;
+
+		_memoryUsed += texture.memorySize;
+		if (_memoryUsed > _memoryHighWater) {
+			_memoryHighWater = _memoryUsed;
+		}
+		evictToBudget();
+	}
+
+	void TextureCache::evictToBudget() {
+		if (_memoryBudget == 0 || _memoryUsed <= _memoryBudget) {
+			return;
+		}
+
+		//Anything somebody still has a reference to stays, and so does anything used this frame,
+		//otherwise a budget that's too small would delete and reload the same textures every frame.
+		std::vector<TextureHandle> candidates;
+		for (TextureHandle handle = 0; handle < (TextureHandle)_textures.size(); handle++) {
+			const CacheEntry& entry = _textures[handle];
+			if (entry.loaded && entry.numReferences == 0 && entry.lastUsedFrame != _frame) {
+				candidates.push_back(handle);
+			}
+		}
+		std::sort(candidates.begin(), candidates.end(), [this](TextureHandle a, TextureHandle b) {
+			return _textures[a].lastUsedFrame < _textures[b].lastUsedFrame;
+		});
+
+		for (TextureHandle handle : candidates) {
+			if (_memoryUsed <= _memoryBudget) {
+				break;
+			}
+			CacheEntry& entry = _textures[handle];
+			glDeleteTextures(1, &(entry.texture.id));
+			_memoryUsed -= entry.texture.memorySize;
+			_numEvicted++;
+
+			//Drawing with it by accident shows the placeholder instead of a deleted texture.
+			entry.texture = _placeholder;
+			entry.loaded = false;
+		}
+	}
+
+	bool TextureCache::isTextureFile(std::string_view filePath) {
+		return CompressedImageLoader::isCompressedFile(filePath) ||
+			(filePath.size() >= 4 && AssetArchive::pathsMatch(filePath.substr(filePath.size() - 4), ".png"));
+	}
+
+	void TextureCache::initAsync() {
+		if (_placeholder.id != 0) {
+			return;
+		}
+
+		//This is the first async load, so we know openGL is up by now.
+		DecodedImage placeholder;
+		placeholder.pixels = { 0, 0, 0, 0 };
+		placeholder.width = 1;
+		placeholder.height = 1;
+		TextureOptions options;
+		options.mipmaps = MipmapMode::NONE;
+		_placeholder = ImageLoader::uploadTexture(placeholder, options);
+
+		_threadPool.init();
+	}
+
+	bool TextureCache::uploadFinished() {
+		DecodedTexture decoded;
+		{
+			std::lock_guard<std::mutex> lock(_decodedMutex);
+			if (_decoded.empty()) {
+				return false;
+			}
+			decoded = std::move(_decoded.front());
+			_decoded.pop_front();
+		}
+
+		if (!decoded.error.empty()) {
+			fatalError(decoded.error);
+		}
+
+		_numLoading--;
+		setLoaded(decoded.handle, ImageLoader::uploadTexture(decoded.image, _textures[decoded.handle].options));
+		return true;
+	}
+
+	void TextureCache::waitForDecoded() {
+		std::unique_lock<std::mutex> lock(_decodedMutex);
+		_decodedAdded.wait(lock, [this]() { return !_decoded.empty(); });
 	}
 }
@@ -1,10 +1,23 @@
 #pragma once
 
 #include "GLTexture.h"
+#include "ImageLoader.h"
+#include "ThreadPool.h"
 
-#include <map>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace GameEngine {
+
+	//Handed out by loadTexture and loadTextureAsync. It's just the texture's spot in the cache, and it never
+	//changes for that path, so hang on to it and use getTexture(handle) every frame instead of looking the path up again.
+	typedef int TextureHandle;
+
 	/*
 	This class is so that when we render a texture mulitple times, we don't have to keep
 	multiple instances of the same image in the cached memory, we only need it in there
@@ -14,6 +27,16 @@ namespace GameEngine {
 	need that ordered data structure because if we were trying to search for an item in a very
 	large array, we would have to iterate through it every time. If we have 100,000 textures,
 	that would be really shitty. The number of times you have to search in a map is log2(n) I think.
+
+	Now it's an unordered_map (a hash map) instead. It turns the path into a number and jumps
+	straight to it, so it doesn't have to compare the path against log2(n) other paths.
+	The keys are string_views that point at our own copy of each path, so looking something
+	up doesn't have to make a new std::string. Even better, look it up once and keep the handle.
+
+	Textures can also be loaded in the background. loadTextureAsync gives back a handle right
+	away and a worker thread reads and decodes the png. Only the upload to openGL has to happen
+	on the main thread, update does that a few at a time each frame. Until then the handle
+	gives back a placeholder texture (one see through pixel) so drawing with it is still fine.
 	*/
 	class TextureCache
 	{
@@ -21,13 +44,108 @@ namespace GameEngine {
 		TextureCache();
 		~TextureCache();
 
-		//This is to find a texture within our map if it exists.
-		GLTexture getTexture(std::string texturePath);
+		//This is to find a texture within our map if it exists, and load it right now if it doesn't.
+		//If it's still loading in the background, this waits for it.
+		//options only count the first time a path is loaded, after that everyone gets the same texture.
+		//The handle comes with a reference, see releaseTexture.
+		TextureHandle loadTexture(std::string_view texturePath, const TextureOptions& options = TextureOptions());
+		//Whoever calls this keeps a copy of the texture id, which can't follow it if it's evicted, so this adds a
+		//reference too and the texture stays loaded for good. Sprite and TextureAtlas load their textures this way.
+		GLTexture getTexture(std::string_view texturePath, const TextureOptions& options = TextureOptions()) { return getTexture(loadTexture(texturePath, options)); }
+
+		//Starts loading in the background if it isn't loaded or loading already. Also adds a reference.
+		TextureHandle loadTextureAsync(std::string_view texturePath, const TextureOptions& options = TextureOptions());
+		//Starts loading every png, ktx and dds in folder and the folders inside of it.
+		std::vector<TextureHandle> loadDirectoryAsync(const std::string& folderPath, const TextureOptions& options = TextureOptions());
+
+		//The real texture once it's uploaded, the placeholder before that.
+		const GLTexture& getTexture(TextureHandle handle) const;
+		const std::string& getPath(TextureHandle handle) const { return _paths[handle]; }
+		bool isLoaded(TextureHandle handle) const { return _textures[handle].loaded; }
+		//How many textures are still waiting to be decoded or uploaded.
+		int getNumLoading() const { return _numLoading; }
+
+		//Every loadTexture and loadTextureAsync adds a reference to the handle, and releaseTexture takes one away.
+		//When nobody has a reference, the texture stays loaded (in case it's wanted again) until we go over
+		//the memory budget, then the ones that were drawn longest ago get deleted first. The handle still
+		//works afterwards, loading the same path again just brings it back.
+		void addReference(TextureHandle handle) { _textures[handle].numReferences++; }
+		void releaseTexture(TextureHandle handle);
+
+		//0 means no budget, textures are never deleted. That's the default.
+		void setMemoryBudget(size_t bytes);
+		size_t getMemoryBudget() const { return _memoryBudget; }
+		//How much video memory all of the loaded textures take, added up from GLTexture::memorySize.
+		size_t getMemoryUsed() const { return _memoryUsed; }
+		//The most getMemoryUsed has ever been.
+		size_t getMemoryHighWater() const { return _memoryHighWater; }
+		int getNumEvicted() const { return _numEvicted; }
+		//Prints every loaded texture's size, biggest first.
+		void printMemoryReport() const;
+
+		//Call once a frame. Uploads decoded textures until maxMilliseconds is used up,
+		//but always at least one so loading can't get stuck behind a slow frame.
+		//This is also how we know what "drawn longest ago" means for the memory budget.
+		void update(float maxMilliseconds);
+		//Uploads everything, waiting for the workers if they aren't done. Good for loading screens.
+		void finishLoading();
 
 	private:
+		struct CacheEntry {
+			GLTexture texture;
+			TextureOptions options; //kept so it loads the same way if it's evicted and loaded again
+			bool loaded;
+			bool loading; //a worker has it. Neither loaded or loading means it was evicted.
+			int numReferences;
+			mutable unsigned int lastUsedFrame; //getTexture is const, but it still counts as using it
+		};
+
+		//Filled in by a worker, then picked up by update.
+		struct DecodedTexture {
+			TextureHandle handle;
+			DecodedImage image;
+			std::string error;
+		};
+
+		//loadTexture without adding a reference.
+		TextureHandle findTexture(std::string_view texturePath, const TextureOptions& options);
+		//Keeps our own copy of the path and gives it the next handle.
+		TextureHandle addTexture(std::string_view texturePath, const TextureOptions& options);
+		//Hands the texture to a worker.
+		void startLoading(TextureHandle handle);
+		//Keeps _memoryUsed up to date whenever a texture is uploaded.
+		void setLoaded(TextureHandle handle, const GLTexture& texture);
+		//Deletes unreferenced textures, least recently drawn first, until we're back under the budget.
+		void evictToBudget();
+		//The kinds of files ImageLoader::loadTexture knows how to read.
+		static bool isTextureFile(std::string_view filePath);
+		void initAsync();
+		//Uploads one finished texture, returns false if none were finished.
+		bool uploadFinished();
+		//Sleeps until a worker finishes something.
+		void waitForDecoded();
+
 		//This looks weird, but it's just defining the type
 		//before initializing _textureMap.
-		std::map<std::string, GLTexture> _textureMap;
+		std::unordered_map<std::string_view, TextureHandle> _textureMap;
+		//The views in _textureMap point into these. A deque never moves what's already in it
+		//when it grows (a vector would), so the views stay good.
+		std::deque<std::string> _paths;
+		std::vector<CacheEntry> _textures;
+		int _numLoading;
+
+		size_t _memoryBudget;
+		size_t _memoryUsed;
+		size_t _memoryHighWater;
+		int _numEvicted;
+		unsigned int _frame; //counts calls to update
+
+		GLTexture _placeholder;
+		ThreadPool _threadPool;
 
+		//Everything below is shared with the worker threads, so only touch it with _decodedMutex locked.
+		std::deque<DecodedTexture> _decoded;
+		std::mutex _decodedMutex;
+		std::condition_variable _decodedAdded;
 	};
 }
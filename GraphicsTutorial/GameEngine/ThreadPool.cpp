@@ -0,0 +1,75 @@
+#include "ThreadPool.h"
+
+namespace GameEngine {
+
+	ThreadPool::ThreadPool() :
+		_quit(false)
+	{
+	}
+
+
+	ThreadPool::~ThreadPool()
+	{
+		destroy();
+	}
+
+	void ThreadPool::init(int numThreads) {
+		if (!_threads.empty()) {
+			return;
+		}
+
+		if (numThreads <= 0) {
+			//hardware_concurrency can return 0 if it can't tell, we still want at least one worker.
+			numThreads = (int)std::thread::hardware_concurrency() - 1;
+			if (numThreads < 1) {
+				numThreads = 1;
+			}
+		}
+
+		_quit = false;
+		for (int i = 0; i < numThreads; i++) {
+			_threads.emplace_back(&ThreadPool::workerLoop, this);
+		}
+	}
+
+	void ThreadPool::destroy() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_quit = true;
+			_jobs.clear();
+		}
+		_jobAdded.notify_all();
+
+		for (auto& thread : _threads) {
+			thread.join();
+		}
+		_threads.clear();
+	}
+
+	void ThreadPool::addJob(std::function<void()> job) {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_jobs.push_back(std::move(job));
+		}
+		_jobAdded.notify_one();
+	}
+
+	void ThreadPool::workerLoop() {
+		while (true) {
+			std::function<void()> job;
+			{
+				//wait lets go of the lock while it sleeps, and has it again when it wakes up.
+				std::unique_lock<std::mutex> lock(_mutex);
+				_jobAdded.wait(lock, [this]() { return _quit || !_jobs.empty(); });
+				if (_quit) {
+					return;
+				}
+				job = std::move(_jobs.front());
+				_jobs.pop_front();
+			}
+			//Run it without holding the lock, so the other threads can grab jobs at the same time.
+			job();
+		}
+	}
+
+}
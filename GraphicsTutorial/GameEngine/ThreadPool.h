@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GameEngine {
+
+	/*A few threads that sit and wait for jobs. addJob puts a function in a queue, and whichever
+	thread is free first takes it off and runs it. This is for slow work that doesn't need
+	openGL, like reading and decoding images, so the main thread can keep drawing frames.
+	Jobs can't call any gl functions, openGL only works on the thread that made the window.*/
+
+	class ThreadPool
+	{
+	public:
+		ThreadPool();
+		~ThreadPool();
+
+		//numThreads 0 means one less than the number of cores, so the main thread gets a core to itself.
+		void init(int numThreads = 0);
+		//Throws away any jobs that haven't started yet, waits for the running ones, and stops the threads.
+		void destroy();
+
+		void addJob(std::function<void()> job);
+
+		int getNumThreads() const { return _threads.size(); }
+
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> _threads;
+		std::deque<std::function<void()>> _jobs;
+		std::mutex _mutex;
+		std::condition_variable _jobAdded;
+		bool _quit;
+	};
+
+}
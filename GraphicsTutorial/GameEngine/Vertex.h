@@ -1,6 +1,8 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <algorithm> //std::min, std::max
+#include <cstddef> //offsetof
 
 namespace GameEngine {
 
@@ -32,11 +34,28 @@ namespace GameEngine {
 		float v;
 	};
 
+	//One attribute of a vertex format, everything glVertexAttribPointer needs to know about it.
+	//Each format lists its attributes in ATTRIBUTES, and setVertexAttributes (at the bottom)
+	//turns those into the glVertexAttribPointer calls, so nobody writes them out by hand.
+	struct VertexAttribute {
+		GLuint index; //the number addAttribute gave it in the shader
+		GLint size; //how many numbers, 2 for a position
+		GLenum type;
+		GLboolean normalized; //GL_TRUE turns 0 to 255 (or 0 to 65535) into 0.0 to 1.0 for the shader
+		size_t offset;
+	};
+
+	//20 bytes, the position and uv are plain floats.
 	struct Vertex {
 		Position position;
 		Color color;
 		UV uv;
 
+		//Positions are stored as they are, see PackedVertex for why this wouldn't be 1.
+		static constexpr float POSITION_SCALE = 1.0f;
+		static constexpr int NUM_ATTRIBUTES = 3;
+		static const VertexAttribute ATTRIBUTES[NUM_ATTRIBUTES];
+
 		//And apparently this doesn't take up anymore space in the ram, so that's good.
 		void setPosition(float x, float y) {
 			position.x = x;
@@ -57,4 +76,87 @@ namespace GameEngine {
 
 	};
 
+	//Has to be out here, offsetof only works once the struct is finished.
+	inline const VertexAttribute Vertex::ATTRIBUTES[Vertex::NUM_ATTRIBUTES] = {
+		{ 0, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, position) },
+		{ 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, color) },
+		{ 2, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, uv) }
+	};
+
+	/*12 bytes instead of 20, for when the vertex upload is what's slow.
+	The uv is two 16 bit numbers that openGL turns back into 0.0 to 1.0 (normalized), which is still
+	16 steps per pixel on a 4096 wide texture. Uvs outside of 0 to 1 (repeating a texture) get clamped.
+
+	The position is two 16 bit integers counting quarter pixels from the batch's origin
+	(SpriteBatch::setVertexOrigin), so it reaches 8191 units either way. Anything further than that gets
+	clamped, so keep the origin on the camera and the cull rect on, then nothing on screen is that far.
+	The shader gets the integers as they are, SpriteBatch::getVertexTransform is the matrix that turns
+	them back into world positions. The color is the same as Vertex.*/
+	struct PackedVertex {
+		GLshort position[2];
+		Color color;
+		GLushort uv[2];
+
+		static constexpr float POSITION_SCALE = 4.0f;
+		static constexpr int NUM_ATTRIBUTES = 3;
+		static const VertexAttribute ATTRIBUTES[NUM_ATTRIBUTES];
+
+		//x and y are already relative to the origin.
+		void setPosition(float x, float y) {
+			position[0] = packPosition(x);
+			position[1] = packPosition(y);
+		}
+
+		void setColor(GLubyte r, GLubyte g, GLubyte b, GLubyte a) {
+			color.r = r;
+			color.g = g;
+			color.b = b;
+			color.a = a;
+		}
+
+		void setUV(float u, float v) {
+			uv[0] = packUV(u);
+			uv[1] = packUV(v);
+		}
+
+		static GLshort packPosition(float value) {
+			float scaled = value * POSITION_SCALE;
+			scaled = std::min(std::max(scaled, -32767.0f), 32767.0f);
+			//Rounding by hand, std::lround is a function call and this runs 8 times a sprite.
+			return (GLshort)(scaled + ((scaled < 0.0f) ? -0.5f : 0.5f));
+		}
+
+		static GLushort packUV(float value) {
+			value = std::min(std::max(value, 0.0f), 1.0f);
+			return (GLushort)(value * 65535.0f + 0.5f);
+		}
+	};
+
+	inline const VertexAttribute PackedVertex::ATTRIBUTES[PackedVertex::NUM_ATTRIBUTES] = {
+		//GL_FALSE so 12 shows up as 12.0, not 12/32767.
+		{ 0, 2, GL_SHORT, GL_FALSE, offsetof(PackedVertex, position) },
+		{ 1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(PackedVertex, color) },
+		{ 2, 2, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(PackedVertex, uv) }
+	};
+
+	//The vertex format SpriteBatch and StaticSpriteBatch build. Add GAMEENGINE_PACKED_VERTICES to the
+	//preprocessor definitions (for the engine and the game) to switch every batch to PackedVertex.
+	//Packing makes end() slower on the cpu, so it's only worth it when the upload is the slow part.
+#if defined(GAMEENGINE_PACKED_VERTICES)
+	typedef PackedVertex SpriteVertex;
+#else
+	typedef Vertex SpriteVertex;
+#endif
+
+	//Enables and points every attribute of VertexType at the buffer bound to GL_ARRAY_BUFFER,
+	//starting offset bytes in. Needs the vertex array it's for to be bound.
+	template <typename VertexType>
+	void setVertexAttributes(size_t offset = 0) {
+		for (const VertexAttribute& attribute : VertexType::ATTRIBUTES) {
+			glEnableVertexAttribArray(attribute.index);
+			glVertexAttribPointer(attribute.index, attribute.size, attribute.type, attribute.normalized,
+				sizeof(VertexType), (void*)(offset + attribute.offset));
+		}
+	}
+
 }
\ No newline at end of file
@@ -57,10 +57,8 @@ namespace GameEngine {
 		//Set V-Sync On/Off
 		SDL_GL_SetSwapInterval(0);
 
-		//Enable alpha blending
+		//Enable alpha blending. Which blend function to use depends on the sprite, so SpriteBatch sets that.
 		glEnable(GL_BLEND);
-		//Take the source alpha, and get the inverse
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 		return 0;
 	}
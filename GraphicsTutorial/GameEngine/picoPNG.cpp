@@ -1,3 +1,5 @@
+#include "PNGUnfilter.h"
+
 #include <vector>
 
 namespace GameEngine {
@@ -50,6 +52,10 @@ namespace GameEngine {
 		// with no color conversion at all. For anything more complex, another tiny library
 		// is available: LodePNG (lodepng.c(pp)), which is a single source and header file.
 		// Apologies for the compact code style, it's to make this tiny.
+		//
+		// Modified for GameEngine: Huffman symbols are decoded with lookup tables instead of
+		// walking the tree one bit at a time (see HuffmanTree::makeTable and Inflator::peekBits),
+		// and rows of 4 byte pixels are unfiltered with SIMD (see PNGUnfilter).
 
 		static const unsigned long LENBASE[29] = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
 		static const unsigned long LENEXTRA[29] = { 0,0,0,0,0,0,0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4,  4,  5,  5,  5,  5,  0 };
@@ -65,8 +71,16 @@ namespace GameEngine {
 				for (size_t i = 0; i < nbits; i++) result += (readBitFromStream(bitp, bits)) << i;
 				return result;
 			}
+			static unsigned long reverseBits(unsigned long bits, unsigned long num)
+			{ //deflate sends Huffman codes highest bit first but everything else lowest bit first, so table indices are the codes reversed
+				unsigned long result = 0;
+				for (unsigned long i = 0; i < num; i++) result |= ((bits >> i) & 1) << (num - i - 1);
+				return result;
+			}
 			struct HuffmanTree
 			{
+				enum { FIRSTBITS = 9, INVALIDLENGTH = 16 }; //the first table looks at 9 bits, longer codes continue into a second table
+
 				int makeFromLengths(const std::vector<unsigned long>& bitlen, unsigned long maxbitlen)
 				{ //make tree given the lengths
 					unsigned long numcodes = (unsigned long)(bitlen.size()), treepos = 0, nodefilled = 0;
@@ -87,35 +101,73 @@ namespace GameEngine {
 							}
 							else treepos = tree2d[2 * treepos + bit] - numcodes; //subtract numcodes from address to get address value
 						}
+					makeTable(bitlen, tree1d);
 					return 0;
 				}
-				int decode(bool& decoded, unsigned long& result, size_t& treepos, unsigned long bit) const
-				{ //Decodes a symbol from the tree
-					unsigned long numcodes = (unsigned long)tree2d.size() / 2;
-					if (treepos >= numcodes) return 11; //error: you appeared outside the codetree
-					result = tree2d[2 * treepos + bit];
-					decoded = (result < numcodes);
-					treepos = decoded ? 0 : result - numcodes;
-					return 0;
+				void makeTable(const std::vector<unsigned long>& bitlen, const std::vector<unsigned long>& tree1d)
+				{ //make the lookup tables: every index whose low bits are a reversed code gets that code's symbol and length
+					unsigned long numcodes = (unsigned long)(bitlen.size()), headsize = 1ul << FIRSTBITS;
+					std::vector<unsigned long> maxlens(headsize, 0), substart(headsize, 0);
+					for (unsigned long n = 0; n < numcodes; n++) //codes longer than FIRSTBITS share a second table with the other codes that start the same way
+						if (bitlen[n] > FIRSTBITS)
+						{
+							unsigned long index = reverseBits(tree1d[n] >> (bitlen[n] - FIRSTBITS), FIRSTBITS);
+							if (bitlen[n] > maxlens[index]) maxlens[index] = bitlen[n];
+						}
+					size_t size = headsize;
+					for (unsigned long i = 0; i < headsize; i++) if (maxlens[i] > FIRSTBITS) { substart[i] = size; size += 1ul << (maxlens[i] - FIRSTBITS); }
+					tablelen.assign(size, INVALIDLENGTH); tablevalue.assign(size, 0); //INVALIDLENGTH is left wherever no code leads
+					for (unsigned long i = 0; i < headsize; i++) if (maxlens[i] > FIRSTBITS) { tablelen[i] = (unsigned short)maxlens[i]; tablevalue[i] = (unsigned short)substart[i]; } //first table entries pointing at second tables
+					for (unsigned long n = 0; n < numcodes; n++)
+					{
+						unsigned long l = bitlen[n]; if (l == 0) continue;
+						unsigned long reverse = reverseBits(tree1d[n], l);
+						if (l <= FIRSTBITS) //fill every index that starts with this code, whatever bits come after it
+							for (unsigned long i = reverse; i < headsize; i += 1ul << l) { tablelen[i] = (unsigned short)l; tablevalue[i] = (unsigned short)n; }
+						else
+						{
+							unsigned long index = reverse & (headsize - 1), subsize = 1ul << (maxlens[index] - FIRSTBITS);
+							for (unsigned long i = reverse >> FIRSTBITS; i < subsize; i += 1ul << (l - FIRSTBITS)) { tablelen[substart[index] + i] = (unsigned short)l; tablevalue[substart[index] + i] = (unsigned short)n; }
+						}
+					}
+				}
+				unsigned long lookup(unsigned long long bits, unsigned long& length) const
+				{ //decodes the symbol at the start of bits (lowest bit first), length is set to INVALIDLENGTH if no code matches
+					size_t index = (size_t)(bits & ((1ul << FIRSTBITS) - 1));
+					length = tablelen[index];
+					if (length > FIRSTBITS && length != INVALIDLENGTH) //go on into the second table
+					{
+						index = tablevalue[index] + (size_t)((bits >> FIRSTBITS) & ((1ul << (length - FIRSTBITS)) - 1));
+						length = tablelen[index];
+					}
+					return tablevalue[index];
 				}
-				std::vector<unsigned long> tree2d; //2D representation of a huffman tree: The one dimension is "0" or "1", the other contains all nodes and leaves of the tree.
+				std::vector<unsigned long> tree2d; //2D representation of a huffman tree: The one dimension is "0" or "1", the other contains all nodes and leaves of the tree. Only built to catch bad code lengths now.
+				std::vector<unsigned short> tablelen, tablevalue; //code length and symbol for each index, or for first table entries with length > FIRSTBITS, the second table's length and start
 			};
 			struct Inflator
 			{
 				int error;
+				static unsigned long long peekBits(const unsigned char* in, size_t bp, size_t inlength)
+				{ //the next 57 or more bits from bp without moving bp, anything past the end of in reads as 0
+					size_t p = bp >> 3; unsigned long long result = 0;
+					for (size_t i = 0; i < 8 && p + i < inlength; i++) result |= (unsigned long long)in[p + i] << (8 * i);
+					return result >> (bp & 0x7);
+				}
 				void inflate(std::vector<unsigned char>& out, const std::vector<unsigned char>& in, size_t inpos = 0)
 				{
 					size_t bp = 0, pos = 0; //bit pointer and byte pointer
+					size_t inlength = in.size() - inpos; //the blocks only see the data from inpos on
 					error = 0;
 					unsigned long BFINAL = 0;
 					while (!BFINAL && !error)
 					{
-						if (bp >> 3 >= in.size()) { error = 52; return; } //error, bit pointer will jump past memory
+						if (bp >> 3 >= inlength) { error = 52; return; } //error, bit pointer will jump past memory
 						BFINAL = readBitFromStream(bp, &in[inpos]);
 						unsigned long BTYPE = readBitFromStream(bp, &in[inpos]); BTYPE += 2 * readBitFromStream(bp, &in[inpos]);
 						if (BTYPE == 3) { error = 20; return; } //error: invalid BTYPE
-						else if (BTYPE == 0) inflateNoCompression(out, &in[inpos], bp, pos, in.size());
-						else inflateHuffmanBlock(out, &in[inpos], bp, pos, in.size(), BTYPE);
+						else if (BTYPE == 0) inflateNoCompression(out, &in[inpos], bp, pos, inlength);
+						else inflateHuffmanBlock(out, &in[inpos], bp, pos, inlength, BTYPE);
 					}
 					if (!error) out.resize(pos); //Only now we know the true size of out, resize it to that
 				}
@@ -130,13 +182,11 @@ namespace GameEngine {
 				HuffmanTree codetree, codetreeD, codelengthcodetree; //the code tree for Huffman codes, dist codes, and code length codes
 				unsigned long huffmanDecodeSymbol(const unsigned char* in, size_t& bp, const HuffmanTree& codetree, size_t inlength)
 				{ //decode a single symbol from given list of bits with given code tree. return value is the symbol
-					bool decoded; unsigned long ct;
-					for (size_t treepos = 0;;)
-					{
-						if ((bp & 0x07) == 0 && (bp >> 3) > inlength) { error = 10; return 0; } //error: end reached without endcode
-						error = codetree.decode(decoded, ct, treepos, readBitFromStream(bp, in)); if (error) return 0; //stop, an error happened
-						if (decoded) return ct;
-					}
+					if ((bp >> 3) > inlength) { error = 10; return 0; } //error: end reached without endcode
+					unsigned long length, symbol = codetree.lookup(peekBits(in, bp, inlength), length);
+					if (length == HuffmanTree::INVALIDLENGTH) { error = 11; return 0; } //error: the bits aren't any code in the tree
+					bp += length;
+					return symbol;
 				}
 				void getTreeInflateDynamic(HuffmanTree& tree, HuffmanTree& treeD, const unsigned char* in, size_t& bp, size_t inlength)
 				{ //get the tree of a deflated block with dynamic tree, the tree itself is also Huffman compressed with a known tree
@@ -197,8 +247,12 @@ namespace GameEngine {
 					if (btype == 1) { generateFixedTrees(codetree, codetreeD); }
 					else if (btype == 2) { getTreeInflateDynamic(codetree, codetreeD, in, bp, inlength); if (error) return; }
 					for (;;)
-					{
-						unsigned long code = huffmanDecodeSymbol(in, bp, codetree, inlength); if (error) return;
+					{ //a whole length/distance pair is at most 15 + 5 + 15 + 13 = 48 bits, so one peek covers everything this symbol needs
+						if ((bp >> 3) > inlength) { error = 10; return; } //error: end reached without endcode
+						unsigned long long bits = peekBits(in, bp, inlength);
+						unsigned long codelength, code = codetree.lookup(bits, codelength);
+						if (codelength == HuffmanTree::INVALIDLENGTH) { error = 11; return; } //error: the bits aren't any code in the tree
+						bits >>= codelength; bp += codelength;
 						if (code == 256) return; //end code
 						else if (code <= 255) //literal symbol
 						{
@@ -209,12 +263,15 @@ namespace GameEngine {
 						{
 							size_t length = LENBASE[code - 257], numextrabits = LENEXTRA[code - 257];
 							if ((bp >> 3) >= inlength) { error = 51; return; } //error, bit pointer will jump past memory
-							length += readBitsFromStream(bp, in, numextrabits);
-							unsigned long codeD = huffmanDecodeSymbol(in, bp, codetreeD, inlength); if (error) return;
+							length += (size_t)(bits & ((1ul << numextrabits) - 1)); bits >>= numextrabits; bp += numextrabits;
+							unsigned long codelengthD, codeD = codetreeD.lookup(bits, codelengthD);
+							if (codelengthD == HuffmanTree::INVALIDLENGTH) { error = 11; return; } //error: the bits aren't any code in the tree
+							bits >>= codelengthD; bp += codelengthD;
 							if (codeD > 29) { error = 18; return; } //error: invalid dist code (30-31 are never used)
 							unsigned long dist = DISTBASE[codeD], numextrabitsD = DISTEXTRA[codeD];
 							if ((bp >> 3) >= inlength) { error = 51; return; } //error, bit pointer will jump past memory
-							dist += readBitsFromStream(bp, in, numextrabitsD);
+							dist += (unsigned long)(bits & ((1ul << numextrabitsD) - 1)); bp += numextrabitsD;
+							if (dist > pos) { error = 52; return; } //error: the distance goes back past the start of the output
 							size_t start = pos, back = start - dist; //backwards
 							if (pos + length >= out.size()) out.resize((pos + length) * 2); //reserve more room
 							for (size_t i = 0; i < length; i++) { out[pos++] = out[back++]; if (back >= start) back = start - dist; }
@@ -380,6 +437,7 @@ namespace GameEngine {
 			}
 			void unFilterScanline(unsigned char* recon, const unsigned char* scanline, const unsigned char* precon, size_t bytewidth, unsigned long filterType, size_t length)
 			{
+				if (bytewidth == 4 && PNGUnfilter::unFilterScanlineRGBA8(recon, scanline, precon, filterType, length)) return; //SIMD versions for 4 byte pixels, see PNGUnfilter
 				switch (filterType)
 				{
 				case 0: for (size_t i = 0; i < length; i++) recon[i] = scanline[i]; break;
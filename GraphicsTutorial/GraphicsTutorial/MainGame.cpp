@@ -1,7 +1,10 @@
 #include "MainGame.h"
 #include <GameEngine/Errors.h>
 #include <GameEngine/ResourceManager.h>
+#include <GameEngine/IOManger.h>
+#include <GameEngine/DecodedImageCache.h>
 
+#include <filesystem>
 #include <iostream>
 #include <string>
 
@@ -29,22 +32,50 @@ void MainGame::initSystems() {
 
 	GameEngine::init();
 
+	//Shipping builds have the Textures and Shaders folders packed into assets.pak by AssetPacker.
+	//While we're working on the game there isn't one, and everything gets read from the folders like normal.
+	if (std::filesystem::exists("assets.pak")) {
+		GameEngine::IOManger::mountArchive("assets.pak");
+	}
+	//Pngs only get decoded the first time we run, after that the pixels come out of this folder.
+	GameEngine::DecodedImageCache::init("Cache/Textures");
+
 	//This is where we initialize things the game needs, like a window.
 	//This was a lot more complicated, but that complication has moved to the game engine.
 	_window.create("Game Engine", _screenWidth, _screenHeight, 0); 
 
+	//One 40 byte instance per sprite instead of 4 vertices, if the driver can do it.
+	//The batch has to be set up first, it decides which shaders we need.
+	_spriteBatch.init(false, true);
 	initShaders();
-	_spriteBatch.init();
 	_fpsLimiter.init(_maxFPS);
+
+	//This comes back right away, the png gets decoded on another thread while we start drawing.
+	//Premultiplied so its edges don't get dark fringes when it's filtered, see BlendMode::PREMULTIPLIED.
+	GameEngine::TextureOptions playerOptions;
+	playerOptions.premultiplyAlpha = true;
+	_playerTexture = GameEngine::ResourceManager::loadTextureAsync("Textures/jimmyJump_pack/PNG/CharacterRight_Standing.png", playerOptions);
 }
 
 void MainGame::initShaders() {
-	_colorProgram.compileShaders("Shaders/colorShading.vert","Shaders/colorShading.frag");
-	//vertexPosition is the vec2 variable listed in the vertex file from above.
-	_colorProgram.addAttribute("vertexPosition");
-	_colorProgram.addAttribute("vertexColor");
-	_colorProgram.addAttribute("vertexUV");
+	if (_spriteBatch.isInstanced()) {
+		//Same order as the vertex attributes below, SpriteBatch uses the same numbers for both.
+		_colorProgram.compileShaders("Shaders/colorShadingInstanced.vert", "Shaders/colorShading.frag");
+		_colorProgram.addAttribute("instanceRect");
+		_colorProgram.addAttribute("instanceColor");
+		_colorProgram.addAttribute("instanceUV");
+	} else {
+		_colorProgram.compileShaders("Shaders/colorShading.vert","Shaders/colorShading.frag");
+		//vertexPosition is the vec2 variable listed in the vertex file from above.
+		_colorProgram.addAttribute("vertexPosition");
+		_colorProgram.addAttribute("vertexColor");
+		_colorProgram.addAttribute("vertexUV");
+	}
 	_colorProgram.linkShaders();
+
+	//Look the uniforms up once here instead of by name every frame.
+	_samplerUniform = _colorProgram.getUniform("mySampler");
+	_projectionUniform = _colorProgram.getUniform("P");
 }
 
 void MainGame::proccessInput() {
@@ -136,35 +167,38 @@ void MainGame::drawGame() {
 	//The texture is now being bound in _sprite.draw()
 	//Because you can have multiple textures bound at one time, we are going to use the first one.
 	glActiveTexture(GL_TEXTURE0);
-	GLint textureLocation = _colorProgram.getUniformLocation("mySampler");
 
 	//I accidentally had the texture location set to 1, this came up with a black screen.
 	//If you are doing multitexture, you would set the texture location equal to the active texture set above.
-	glUniform1i(textureLocation, 0);
+	_colorProgram.setUniform(_samplerUniform, 0);
 
 	//This is the P variable in our colorshading.vert. The P variable is for our orthogrphaic
 	//matrix from the Camera2D class.
-	GLint pLocation = _colorProgram.getUniformLocation("P");
-	glm::mat4 cameraMatrix = _camera.getCameraMatrix();
+	//The sprite batch writes its vertices relative to the camera (and maybe packed into 16 bit numbers),
+	//so its vertex transform has to go in front of the camera's own matrix.
+	_spriteBatch.setVertexOrigin(_camera.getPosition());
+	glm::mat4 cameraMatrix = _camera.getCameraMatrix() * _spriteBatch.getVertexTransform();
 	
 	//now we need to upload the matrix to the gpu with gluniform calls
-	//The last parameter is the value, which is our cameraMatrix. We need to pass
-	// it in byref, and to do that we pass in its a pointer to its first index, just
+	//setUniform passes glUniformMatrix4fv a pointer to its first index, just
 	//like we would with an other vector/array. A matrix is a two-dimensional array bassically, 
-	glUniformMatrix4fv(pLocation, 1, GL_FALSE, &(cameraMatrix[0][0]));
+	_colorProgram.setUniform(_projectionUniform, cameraMatrix);
 
+	//Anything the camera can't see gets dropped in draw instead of being sorted and uploaded.
+	_spriteBatch.setCullRect(_camera.getVisibleRect());
 	_spriteBatch.begin();
 
 	glm::vec4 pos(0.0f, 0.0f, 50.f, 50.0f);
 	glm::vec4 uv(0.0f, 0.0f, 1.0f, 1.0f);
-	GameEngine::GLTexture texture = GameEngine::ResourceManager::getTexture("Textures/jimmyJump_pack/PNG/CharacterRight_Standing.png");
+	//This is a see through placeholder for the first few frames, until the real one is uploaded.
+	const GameEngine::GLTexture& texture = GameEngine::ResourceManager::getTexture(_playerTexture);
 	GameEngine::Color color;
 	color.r = 255;
 	color.g = 255;
 	color.b = 255;
 	color.a = 255;
 
-	_spriteBatch.draw(pos, uv, texture.id, 0.0f, color);
+	_spriteBatch.draw(pos, uv, texture.id, 0.0f, color, GameEngine::BlendMode::PREMULTIPLIED);
 
 	_spriteBatch.end();
 
@@ -186,6 +220,10 @@ void MainGame::gameLoop() {
 		proccessInput();
 		_time += 0.01f;
 
+		//Textures that finished decoding get sent to openGL here, but only a couple milliseconds worth per frame.
+		const float TEXTURE_UPLOAD_MS = 2.0f;
+		GameEngine::ResourceManager::updateTextureLoading(TEXTURE_UPLOAD_MS);
+
 		_camera.update();
 
 		drawGame();
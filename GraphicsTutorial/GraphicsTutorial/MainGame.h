@@ -12,6 +12,7 @@
 #include <GameEngine\SpriteBatch.h>
 #include <GameEngine\InputManager.h>
 #include <GameEngine\Timing.h>
+#include <GameEngine\TextureCache.h>
 
 #include <vector>
 
@@ -38,7 +39,9 @@ private:
 	GameState _gameState;
 
 	GameEngine::GLSLProgram _colorProgram;
-	GameEngine::GLTexture _playerTexture;
+	GameEngine::UniformHandle _samplerUniform;
+	GameEngine::UniformHandle _projectionUniform;
+	GameEngine::TextureHandle _playerTexture;
 	GameEngine::Camera2D _camera;
 	GameEngine::SpriteBatch _spriteBatch;
 	GameEngine::InputManager _inputManager;
@@ -0,0 +1,19 @@
+#version 130
+//Same as colorShading.frag, but the sampler is a whole TextureArray
+//and we pick which image (layer) to read from with fragmentLayer.
+
+in vec2 fragmentPosition;
+in vec4 fragmentColor;
+in vec2 fragmentUV;
+flat in float fragmentLayer;
+
+out vec4 color;
+
+//A sampler2DArray takes a vec3, the third number is the layer.
+uniform sampler2DArray mySampler;
+
+void main() {
+	vec4 textureColor = texture(mySampler, vec3(fragmentUV, fragmentLayer));
+
+	color = fragmentColor * textureColor; 
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#version 130
+//Same as colorShading.vert, but for sprites that come from a TextureArray.
+//Each vertex also has the layer its image is in, which we just pass along to the fragment shader.
+
+in vec2 vertexPosition;
+in vec4 vertexColor;
+in vec2 vertexUV;
+in float vertexLayer;
+
+out vec2 fragmentPosition;
+out vec4 fragmentColor;
+out vec2 fragmentUV;
+//flat means don't blend this between the corners, all 4 corners of a sprite have the same layer anyway.
+flat out float fragmentLayer;
+
+//our orthographic matrix
+uniform mat4 P;
+
+void main() {
+	gl_Position.xy = (P * vec4(vertexPosition, 0.0, 1.0)).xy;
+	
+	//the z position is zero since we are in 2d
+	gl_Position.z = 0.0;
+	
+	//indicate that the coordinates are normalized.
+	gl_Position.w = 1.0;
+	
+	fragmentPosition = vertexPosition;
+	fragmentColor = vertexColor;
+	fragmentLayer = vertexLayer;
+	
+	//Because opengl uses weird inverted vertical coordinates, we have to flip them
+	fragmentUV = vec2(vertexUV.x, 1.0 - vertexUV.y);
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#version 130
+//colorShadingInstanced.vert for sprites that come from a TextureArray.
+//The layer is part of the instance, so it goes with colorShadingArray.frag.
+
+in vec4 instanceRect; //x, y, width, height
+in vec4 instanceColor;
+in vec4 instanceUV; //same layout as instanceRect
+in float instanceLayer;
+
+out vec2 fragmentPosition;
+out vec4 fragmentColor;
+out vec2 fragmentUV;
+flat out float fragmentLayer;
+
+//our orthographic matrix
+uniform mat4 P;
+
+void main() {
+	//Bit 0 picks left or right, bit 1 picks bottom or top.
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	vec2 vertexPosition = instanceRect.xy + corner * instanceRect.zw;
+	vec2 vertexUV = instanceUV.xy + corner * instanceUV.zw;
+
+	gl_Position.xy = (P * vec4(vertexPosition, 0.0, 1.0)).xy;
+	
+	//the z position is zero since we are in 2d
+	gl_Position.z = 0.0;
+	
+	//indicate that the coordinates are normalized.
+	gl_Position.w = 1.0;
+	
+	fragmentPosition = vertexPosition;
+	fragmentColor = instanceColor;
+	fragmentLayer = instanceLayer;
+	
+	//Because opengl uses weird inverted vertical coordinates, we have to flip them
+	fragmentUV = vec2(vertexUV.x, 1.0 - vertexUV.y);
+}
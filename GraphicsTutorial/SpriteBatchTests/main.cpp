@@ -0,0 +1,110 @@
+#include <GameEngine\SpriteBatch.h>
+
+#include <cstdio>
+#include <string>
+
+using namespace GameEngine;
+
+/*Checks that SpriteBatch puts sprites into as few render batches as it should.
+The batch is never init()'d, so end() builds everything on the cpu and we can read the batches
+back with getRenderBatches(). That means no window and no openGL context, it just runs.
+Returns 0 if everything passed, so it can be run after a build.*/
+
+static int numFailed = 0;
+
+static void check(bool passed, const std::string& what) {
+	printf("%s %s\n", passed ? "PASS" : "FAIL", what.c_str());
+	if (!passed) {
+		numFailed++;
+	}
+}
+
+//Every sprite is the same size and color, only the texture and blend mode matter for batching.
+static void drawSprite(SpriteBatch& spriteBatch, GLuint texture, BlendMode blendMode = BlendMode::ALPHA) {
+	Color color;
+	color.r = 255;
+	color.g = 255;
+	color.b = 255;
+	color.a = 255;
+	spriteBatch.draw(glm::vec4(0.0f, 0.0f, 50.0f, 50.0f), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), texture, 0.0f, color, blendMode);
+}
+
+static void testOneTexture(int numSprites) {
+	SpriteBatch spriteBatch;
+	spriteBatch.begin(GlyphSortType::TEXTURE);
+	for (int i = 0; i < numSprites; i++) {
+		drawSprite(spriteBatch, 1);
+	}
+	spriteBatch.end();
+
+	const std::vector<RenderBatch>& batches = spriteBatch.getRenderBatches();
+	check(spriteBatch.getNumRenderBatches() == 1, std::to_string(numSprites) + " sprites on one texture make 1 batch");
+	check(batches.size() == 1 && batches[0].offset == 0 && batches[0].numIndices == (GLuint)numSprites * SpriteBatch::INDICES_PER_QUAD,
+		"that batch draws all " + std::to_string(numSprites) + " sprites");
+}
+
+static void testAlternatingTextures(int numSprites) {
+	SpriteBatch spriteBatch;
+
+	//NONE keeps the order we drew them in, so every sprite has a different texture than the one before it.
+	spriteBatch.begin(GlyphSortType::NONE);
+	for (int i = 0; i < numSprites; i++) {
+		drawSprite(spriteBatch, 1 + i % 2);
+	}
+	spriteBatch.end();
+	check(spriteBatch.getNumRenderBatches() == numSprites, std::to_string(numSprites) + " sprites alternating between 2 textures make " + std::to_string(numSprites) + " batches");
+
+	//Sorting by texture puts them back together.
+	spriteBatch.begin(GlyphSortType::TEXTURE);
+	for (int i = 0; i < numSprites; i++) {
+		drawSprite(spriteBatch, 1 + i % 2);
+	}
+	spriteBatch.end();
+	check(spriteBatch.getNumRenderBatches() == 2, "the same sprites sorted by texture make 2 batches");
+}
+
+static void testBlendModes(int numSprites) {
+	SpriteBatch spriteBatch;
+
+	//One texture, but the blend mode changes every sprite, and that has to start a new batch too.
+	spriteBatch.begin(GlyphSortType::NONE);
+	for (int i = 0; i < numSprites; i++) {
+		drawSprite(spriteBatch, 1, (i % 2 == 0) ? BlendMode::ALPHA : BlendMode::ADDITIVE);
+	}
+	spriteBatch.end();
+	check(spriteBatch.getNumRenderBatches() == numSprites, "alternating blend modes on one texture make " + std::to_string(numSprites) + " batches");
+
+	spriteBatch.begin(GlyphSortType::TEXTURE);
+	for (int i = 0; i < numSprites; i++) {
+		drawSprite(spriteBatch, 1, (i % 2 == 0) ? BlendMode::ALPHA : BlendMode::ADDITIVE);
+	}
+	spriteBatch.end();
+	const std::vector<RenderBatch>& batches = spriteBatch.getRenderBatches();
+	check(batches.size() == 2 && batches[0].blendMode == BlendMode::ALPHA && batches[1].blendMode == BlendMode::ADDITIVE,
+		"sorted by texture they make 2 batches, alpha first and additive last");
+}
+
+static void testEmpty() {
+	//Nothing drawn (or everything culled) is a normal frame, it should just make no batches.
+	SpriteBatch spriteBatch;
+	spriteBatch.begin(GlyphSortType::TEXTURE);
+	spriteBatch.end();
+	check(spriteBatch.getNumRenderBatches() == 0, "an empty frame makes 0 batches");
+}
+
+int main() {
+	const int NUM_SPRITES = 1000;
+
+	testOneTexture(1);
+	testOneTexture(NUM_SPRITES);
+	testAlternatingTextures(NUM_SPRITES);
+	testBlendModes(NUM_SPRITES);
+	testEmpty();
+
+	if (numFailed > 0) {
+		printf("%d checks failed\n", numFailed);
+		return 1;
+	}
+	printf("All checks passed\n");
+	return 0;
+}